@@ -0,0 +1,61 @@
+#ifndef MOOCOV_BENCH_H
+#define MOOCOV_BENCH_H
+
+// Minimal helpers shared by the runtime benchmarks.
+
+#include <stdio.h> // printf
+#include <stdlib.h> // strtoull
+#include <time.h> // clock_gettime
+
+// Returns a monotonic timestamp in seconds.
+static inline double bench_now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Parses the argument at the given index as an unsigned integer, or returns the default value if there's no such argument.
+static inline unsigned long long bench_arg(int argc, const char** argv, int index, unsigned long long defaultValue) {
+	return index < argc ? strtoull(argv[index], 0, 10) : defaultValue;
+}
+
+// Prints a single result line: the name of the measurement, the time per operation and the throughput.
+static inline void bench_report(const char* name, double seconds, unsigned long long ops) {
+	printf("%-32s %10.3f ns/op %12.1f Mop/s %10.3f s\n",
+		name,
+		seconds * 1e9 / (double)ops,
+		(double)ops / seconds * 1e-6,
+		seconds);
+}
+
+// Prints a result line of a measurement that produces data: the number of counters and the megabytes it went through per second, and the bytes it took per counter.
+static inline void bench_report_throughput(const char* name, double seconds, unsigned long long counters, unsigned long long bytes) {
+	printf("%-32s %10.1f Mcnt/s %10.1f MB/s %6.2f B/cnt %10.3f s\n",
+		name,
+		(double)counters / seconds * 1e-6,
+		(double)bytes / seconds * 1e-6,
+		(double)bytes / (double)counters,
+		seconds);
+}
+
+// Prints a result line of a measurement compared to a baseline measurement of the same number of operations: the time per operation, and how many times slower it is.
+static inline void bench_report_slowdown(const char* name, double seconds, double baselineSeconds, unsigned long long ops) {
+	printf("%-32s %10.3f ns/op %12.2fx slowdown %4.3f s\n",
+		name,
+		seconds * 1e9 / (double)ops,
+		seconds / baselineSeconds,
+		seconds);
+}
+
+// Times STMT, executed ITERATIONS times, and reports it under NAME.
+#define BENCH_RUN(NAME, ITERATIONS, STMT) \
+	do { \
+		unsigned long long _bench_i; \
+		double _bench_start = bench_now(); \
+		for(_bench_i = 0; _bench_i < (ITERATIONS); ++_bench_i) { \
+			STMT; \
+		} \
+		bench_report((NAME), bench_now() - _bench_start, (ITERATIONS)); \
+	} while(0)
+
+#endif // MOOCOV_BENCH_H
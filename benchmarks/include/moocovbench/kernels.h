@@ -0,0 +1,21 @@
+#ifndef MOOCOV_BENCH_KERNELS_H
+#define MOOCOV_BENCH_KERNELS_H
+
+// The synthetic kernels of the overhead benchmarks (see src/kernels.c).
+// The file is parsed by moocov-instrument as well, so it doesn't include any system headers.
+
+// Runs the workload of a kernel over the input once, and returns a result depending on all of it, so that it can't be optimized away.
+typedef unsigned (*bench_kernel_fn)(const unsigned* input, unsigned length);
+
+typedef struct {
+	const char* name;
+	bench_kernel_fn run;
+} bench_kernel_t;
+
+#define BENCH_NUM_KERNELS 4
+
+// The same kernels, compiled as they are, and instrumented by moocov-instrument.
+extern const bench_kernel_t baseline_kernels[BENCH_NUM_KERNELS];
+extern const bench_kernel_t instrumented_kernels[BENCH_NUM_KERNELS];
+
+#endif // MOOCOV_BENCH_KERNELS_H
@@ -0,0 +1,86 @@
+// Measures the cost of concurrent hits on the same signals, and how many of them get lost.
+// This file is built once for each counter mode: plain, atomic (MOOCOV_ATOMIC_COUNTERS) and sharded (MOOCOV_SHARDED_COUNTERS), so the executables can be compared.
+//
+// Usage: moocov-bench-contention[-atomic|-sharded] [iterations per thread] [max threads]
+
+#include <pthread.h>
+
+#include "moocovrt/runtime.h"
+#include "moocovbench/bench.h"
+
+#define NUM_SIGNALS 4
+
+MOOCOV_DEFINE_FILE(contention, NUM_SIGNALS)
+
+static unsigned long long g_iterations;
+static volatile int g_sink;
+
+// A loop with a branch in its body, instrumented the same way moocov-instrument would do it.
+static void* run_kernel(void* arg) {
+	MOOCOV_SIGNAL(contention, 0);
+
+	int acc = 0;
+	unsigned long long i;
+	for(i = 0; i < g_iterations; ++i) {
+		MOOCOV_SIGNAL(contention, 1);
+		if(i & 1) {
+			MOOCOV_SIGNAL(contention, 2);
+			acc += (int)i;
+		} else {
+			MOOCOV_SIGNAL(contention, 3);
+			acc -= (int)i;
+		}
+	}
+
+	g_sink = acc;
+	return 0;
+}
+
+static unsigned long long sum_counters() {
+	unsigned long long sum = 0;
+
+	int i;
+	for(i = 0; i < NUM_SIGNALS; ++i) {
+		sum += ((moocov_data_t*)MOOCOV_FILE(contention).data)[i];
+	}
+
+	return sum;
+}
+
+int main(int argc, const char** argv) {
+	g_iterations = bench_arg(argc, argv, 1, 10000000ULL);
+	unsigned long long maxThreads = bench_arg(argc, argv, 2, 8);
+
+	printf("mode: %s\n", MOOCOV_ATOMIC_COUNTERS ? "atomic" : MOOCOV_SHARDED_COUNTERS ? "sharded" : "plain");
+
+	unsigned long long numThreads;
+	for(numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+		pthread_t threads[64];
+		if(numThreads > sizeof(threads) / sizeof(threads[0])) break;
+
+		char name[64];
+		snprintf(name, sizeof(name), "%llu thread(s)", numThreads);
+
+		double start = bench_now();
+
+		unsigned long long t;
+		for(t = 0; t < numThreads; ++t) {
+			pthread_create(&threads[t], 0, run_kernel, 0);
+		}
+
+		for(t = 0; t < numThreads; ++t) {
+			pthread_join(threads[t], 0);
+		}
+
+		// each iteration hits two signals, plus the function entry signal for each thread
+		unsigned long long expected = numThreads * (2 * g_iterations + 1);
+		unsigned long long counted = sum_counters();
+
+		bench_report(name, bench_now() - start, numThreads * g_iterations);
+		printf("%-32s %llu of %llu hits lost\n", "", expected - counted, expected);
+
+		moocov_reset();
+	}
+
+	return 0;
+}
@@ -0,0 +1,100 @@
+// Measures how fast moocov_dump() writes out large files at exit, in counters and megabytes of the data file per second.
+// This file is built with each data file format: binary with compact or fixed-width payloads, and text. Unlike the dump benchmark, the data file is really written (and deleted after each dump), so the I/O is included.
+//
+// Usage: moocov-bench-dump-throughput[-fixed|-text] [signals per file] [number of files] [dumps per measurement]
+
+#include <sys/stat.h> // stat
+#include <unistd.h> // unlink
+
+#include "moocovrt/runtime.h"
+#include "moocovbench/bench.h"
+
+#ifndef TEXT_DUMPFILE
+#	define TEXT_DUMPFILE 0
+#endif
+
+#ifndef COMPACT_DUMPFILE
+#	define COMPACT_DUMPFILE 1
+#endif
+
+// The ratios of the signals that are hit, in percent.
+static const unsigned g_hitRatios[] = { 1, 10, 100 };
+
+static unsigned g_random = 12345;
+
+// A simple LCG, so that the same signals get hit in every measurement.
+static unsigned bench_random() {
+	g_random = g_random * 1103515245u + 12345u;
+	return g_random >> 8;
+}
+
+// Hits the given ratio of the signals of the files, and returns the number of signals hit.
+static unsigned long long hit_signals(moocov_file_t* files, unsigned long long numFiles, unsigned hitRatio) {
+	unsigned long long f, i, numHit = 0;
+	for(f = 0; f < numFiles; ++f) {
+		moocov_data_t* data = (moocov_data_t*)files[f].data;
+
+		for(i = 0; i < files[f].dataLength; ++i) {
+			if(bench_random() % 100 < hitRatio) {
+				data[i] = 1 + bench_random() % 100000;
+				++numHit;
+			}
+		}
+	}
+
+	return numHit;
+}
+
+int main(int argc, const char** argv) {
+	unsigned long long numSignals = bench_arg(argc, argv, 1, 1 << 20);
+	unsigned long long numFiles = bench_arg(argc, argv, 2, 8);
+	unsigned long long numDumps = bench_arg(argc, argv, 3, 5);
+
+	printf("mode: %s, %llu files of %llu signals\n", TEXT_DUMPFILE ? "text" : COMPACT_DUMPFILE ? "binary (compact)" : "binary (fixed-width)", numFiles, numSignals);
+
+	moocov_file_t* files = (moocov_file_t*)calloc(numFiles, sizeof(moocov_file_t));
+	char (*ids)[32] = (char(*)[32])calloc(numFiles, sizeof(*ids));
+	if(!files || !ids) return 1;
+
+	unsigned long long f;
+	for(f = 0; f < numFiles; ++f) {
+		snprintf(ids[f], sizeof(ids[f]), "file%llu", f);
+
+		files[f].id = ids[f];
+		files[f].kind = MOOCOV_KIND_COUNTS;
+		files[f].data = calloc(numSignals, sizeof(moocov_data_t));
+		files[f].dataLength = numSignals;
+		if(!files[f].data) return 1;
+
+		_moocov_link(&files[f]);
+	}
+
+	unlink(DUMPFILE_NAME);
+
+	unsigned r;
+	for(r = 0; r < sizeof(g_hitRatios) / sizeof(g_hitRatios[0]); ++r) {
+		char name[64];
+		snprintf(name, sizeof(name), "%u%% hit", g_hitRatios[r]);
+
+		// only the dumps are timed, not hitting the signals
+		double seconds = 0;
+		unsigned long long numCounters = 0, numBytes = 0;
+
+		unsigned long long d;
+		for(d = 0; d < numDumps; ++d) {
+			numCounters += hit_signals(files, numFiles, g_hitRatios[r]);
+
+			double start = bench_now();
+			moocov_dump();
+			seconds += bench_now() - start;
+
+			struct stat st;
+			if(stat(DUMPFILE_NAME, &st) == 0) numBytes += (unsigned long long)st.st_size;
+			unlink(DUMPFILE_NAME);
+		}
+
+		bench_report_throughput(name, seconds, numCounters, numBytes);
+	}
+
+	return 0;
+}
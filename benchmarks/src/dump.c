@@ -0,0 +1,85 @@
+// Measures the cost of moocov_dump() on large synthetic files, depending on how many of their signals were hit.
+// This file is built with and without SIMD_ZERO_SKIP, so that the zero-skipping can be compared to checking the signals one by one.
+// The data is written to /dev/null, so that the disk doesn't get measured.
+//
+// Usage: moocov-bench-dump[-scalar|-avx2] [signals per file] [number of files] [dumps per measurement]
+
+#include "moocovrt/runtime.h"
+#include "moocovbench/bench.h"
+
+// the same default as in the runtime
+#ifndef SIMD_ZERO_SKIP
+#	define SIMD_ZERO_SKIP 1
+#endif
+
+// The ratios of the signals that are hit, in 1/1000000ths.
+static const unsigned g_hitRatios[] = { 0, 10, 100, 1000, 10000, 100000, 500000 };
+
+static unsigned g_random = 12345;
+
+// A simple LCG, so that the same signals get hit in every measurement.
+static unsigned bench_random() {
+	g_random = g_random * 1103515245u + 12345u;
+	return g_random >> 8;
+}
+
+// Hits the given ratio of the signals of the files.
+static void hit_signals(moocov_file_t* files, unsigned long long numFiles, unsigned hitRatio) {
+	unsigned long long f, i;
+	for(f = 0; f < numFiles; ++f) {
+		moocov_data_t* data = (moocov_data_t*)files[f].data;
+
+		for(i = 0; i < files[f].dataLength; ++i) {
+			if(bench_random() % 1000000 < hitRatio) {
+				data[i] = 1 + bench_random() % 100;
+			}
+		}
+	}
+}
+
+int main(int argc, const char** argv) {
+	unsigned long long numSignals = bench_arg(argc, argv, 1, 1 << 20);
+	unsigned long long numFiles = bench_arg(argc, argv, 2, 8);
+	unsigned long long numDumps = bench_arg(argc, argv, 3, 10);
+
+	printf("mode: %s, %llu files of %llu signals\n", SIMD_ZERO_SKIP ? "zero-skipping" : "scalar", numFiles, numSignals);
+
+	moocov_file_t* files = (moocov_file_t*)calloc(numFiles, sizeof(moocov_file_t));
+	char (*ids)[32] = (char(*)[32])calloc(numFiles, sizeof(*ids));
+	if(!files || !ids) return 1;
+
+	unsigned long long f;
+	for(f = 0; f < numFiles; ++f) {
+		snprintf(ids[f], sizeof(ids[f]), "file%llu", f);
+
+		files[f].id = ids[f];
+		files[f].kind = MOOCOV_KIND_COUNTS;
+		files[f].data = calloc(numSignals, sizeof(moocov_data_t));
+		files[f].dataLength = numSignals;
+		if(!files[f].data) return 1;
+
+		_moocov_link(&files[f]);
+	}
+
+	unsigned r;
+	for(r = 0; r < sizeof(g_hitRatios) / sizeof(g_hitRatios[0]); ++r) {
+		char name[64];
+		snprintf(name, sizeof(name), "%.4f%% hit", g_hitRatios[r] / 10000.0);
+
+		// only the dumps are timed, not hitting the signals
+		double seconds = 0;
+
+		unsigned long long d;
+		for(d = 0; d < numDumps; ++d) {
+			hit_signals(files, numFiles, g_hitRatios[r]);
+
+			double start = bench_now();
+			moocov_dump();
+			seconds += bench_now() - start;
+		}
+
+		bench_report(name, seconds, numDumps * numFiles * numSignals);
+	}
+
+	return 0;
+}
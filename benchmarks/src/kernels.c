@@ -0,0 +1,78 @@
+// Synthetic kernels for measuring the overhead of instrumentation, each stressing a different kind of signal.
+// This file is compiled twice into each overhead benchmark: as it is, defining baseline_kernels, and instrumented by moocov-instrument at build time, defining instrumented_kernels.
+
+#include "moocovbench/kernels.h"
+
+#ifndef KERNELS
+#	define KERNELS instrumented_kernels
+#endif
+
+// A single signal per iteration, in a loop that does next to nothing else.
+static unsigned tight_loop(const unsigned* input, unsigned length) {
+	unsigned sum = 0;
+	for(unsigned i = 0; i < length; ++i) {
+		sum += input[i];
+	}
+
+	return sum;
+}
+
+// A chain of data-dependent branches, each with its own signal.
+static unsigned branchy(const unsigned* input, unsigned length) {
+	unsigned result = 0;
+	for(unsigned i = 0; i < length; ++i) {
+		unsigned value = input[i];
+
+		if(value % 3 == 0) {
+			result += 1;
+		} else if(value % 5 == 0) {
+			result ^= value;
+		} else if(value & 1) {
+			result += value >> 1;
+		} else {
+			result -= 7;
+		}
+	}
+
+	return result;
+}
+
+// Conditions built of && and || operators, whose operands get their own signals.
+static unsigned short_circuit(const unsigned* input, unsigned length) {
+	unsigned count = 0;
+	for(unsigned i = 0; i < length; ++i) {
+		unsigned value = input[i];
+
+		if(((value & 1) && value % 3 != 0) || (value > 1000 && !(value & 4))) {
+			++count;
+		}
+
+		count += value % 7 == 0 && value % 11 != 0;
+	}
+
+	return count;
+}
+
+// Small functions calling each other, which can't be inlined, so that each call hits the signals at the entry (and exit) of a function.
+__attribute__((noinline)) static unsigned chain6(unsigned value) { return value * 3 + 1; }
+__attribute__((noinline)) static unsigned chain5(unsigned value) { return chain6(value ^ 5) + 1; }
+__attribute__((noinline)) static unsigned chain4(unsigned value) { return chain5(value >> 1) + 2; }
+__attribute__((noinline)) static unsigned chain3(unsigned value) { return chain4(value + 3) ^ 1; }
+__attribute__((noinline)) static unsigned chain2(unsigned value) { return chain3(value * 5) + 4; }
+__attribute__((noinline)) static unsigned chain1(unsigned value) { return chain2(value - 1) >> 1; }
+
+static unsigned call_chain(const unsigned* input, unsigned length) {
+	unsigned sum = 0;
+	for(unsigned i = 0; i < length; ++i) {
+		sum += chain1(input[i]);
+	}
+
+	return sum;
+}
+
+const bench_kernel_t KERNELS[BENCH_NUM_KERNELS] = {
+	{ "tight loop", tight_loop },
+	{ "branchy", branchy },
+	{ "short-circuit", short_circuit },
+	{ "call chain", call_chain }
+};
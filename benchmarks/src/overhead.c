@@ -0,0 +1,86 @@
+// Measures how much slower the synthetic kernels of kernels.c get when instrumented by moocov-instrument, and the latency of moocov_dump() and moocov_reset() with their data.
+// Built for each compile-time mode of the runtime, with the kernels instrumented for that mode. With ALLOW_DISABLE, the instrumented kernels are also measured while data gathering is disabled.
+//
+// Usage: moocov-bench-overhead-<mode> [input length] [repetitions] [dumps]
+
+#include "moocovrt/runtime.h"
+#include "moocovbench/bench.h"
+#include "moocovbench/kernels.h"
+
+static volatile unsigned g_sink;
+
+// Runs a kernel over the input the given number of times, and returns the time it took.
+static double time_kernel(const bench_kernel_t* kernel, const unsigned* input, unsigned length, unsigned long long repetitions) {
+	unsigned long long i;
+	double start = bench_now();
+
+	for(i = 0; i < repetitions; ++i) {
+		g_sink += kernel->run(input, length);
+	}
+
+	return bench_now() - start;
+}
+
+// Runs every instrumented kernel once, so that there's data to dump or reset, and times the function called after that.
+static void report_latency(const char* name, void (*function)(void), const unsigned* input, unsigned length, unsigned long long rounds) {
+	unsigned long long i;
+	double total = 0;
+
+	for(i = 0; i < rounds; ++i) {
+		unsigned k;
+		for(k = 0; k < BENCH_NUM_KERNELS; ++k) {
+			g_sink += instrumented_kernels[k].run(input, length);
+		}
+
+		double start = bench_now();
+		function();
+		total += bench_now() - start;
+	}
+
+	bench_report(name, total, rounds);
+}
+
+int main(int argc, const char** argv) {
+	unsigned length = (unsigned)bench_arg(argc, argv, 1, 4096);
+	unsigned long long repetitions = bench_arg(argc, argv, 2, 20000);
+	unsigned long long dumps = bench_arg(argc, argv, 3, 1000);
+
+	unsigned* input = (unsigned*)malloc(length * sizeof(unsigned));
+	if(!input) return 1;
+
+	unsigned i, seed = 12345;
+	for(i = 0; i < length; ++i) {
+		seed = seed * 1103515245u + 12345u;
+		input[i] = seed >> 16;
+	}
+
+	unsigned long long ops = repetitions * length;
+
+	unsigned k;
+	for(k = 0; k < BENCH_NUM_KERNELS; ++k) {
+		char name[64];
+
+		// warm up both, so that the first one measured doesn't pay for the page faults
+		time_kernel(&baseline_kernels[k], input, length, 1);
+		time_kernel(&instrumented_kernels[k], input, length, 1);
+
+		double baseline = time_kernel(&baseline_kernels[k], input, length, repetitions);
+		bench_report(baseline_kernels[k].name, baseline, ops);
+
+		snprintf(name, sizeof(name), "%s (instrumented)", instrumented_kernels[k].name);
+		bench_report_slowdown(name, time_kernel(&instrumented_kernels[k], input, length, repetitions), baseline, ops);
+
+#if ALLOW_DISABLE
+		moocov_disable();
+		snprintf(name, sizeof(name), "%s (disabled)", instrumented_kernels[k].name);
+		bench_report_slowdown(name, time_kernel(&instrumented_kernels[k], input, length, repetitions), baseline, ops);
+		moocov_enable();
+#endif
+	}
+
+	report_latency("moocov_dump()", moocov_dump, input, length, dumps);
+	report_latency("moocov_reset()", moocov_reset, input, length, dumps);
+
+	free(input);
+	return 0;
+}
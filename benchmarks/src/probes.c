@@ -0,0 +1,90 @@
+// Compares the cost of call-based (_moocov_signal()) and inline (MOOCOV_SIGNAL()) probes.
+// The kernels are copies of test/runtime/simple.cpp, instrumented by hand the same way moocov-instrument would instrument them.
+// This file is also built with ALLOW_DISABLE, to measure the probes while data gathering is enabled and disabled.
+//
+// Usage: moocov-bench-probes[-disable] [iterations]
+
+#include "moocovrt/runtime.h"
+#include "moocovbench/bench.h"
+
+MOOCOV_DEFINE_FILE(simple, 6)
+
+#define CALL_SIGNAL(INDEX) _moocov_signal(MOOCOV_FILEREF(simple), INDEX)
+#define INLINE_SIGNAL(INDEX) MOOCOV_SIGNAL(simple, INDEX)
+
+static volatile int g_input = 3;
+static volatile int g_sink;
+
+__attribute__((noinline)) static int foo_plain(int c) {
+	return c > 0
+		? (c > 2)
+		: (c - 1);
+}
+
+static int run_plain(int argc) {
+	int result = 0;
+	if(foo_plain(argc)
+		&& argc % 2 == 0)
+	{
+		result = 1;
+	}
+
+	return result;
+}
+
+__attribute__((noinline)) static int foo_call(int c) {
+	CALL_SIGNAL(0);
+	return c > 0
+		? (CALL_SIGNAL(1), (c > 2))
+		: (CALL_SIGNAL(2), (c - 1));
+}
+
+static int run_call(int argc) {
+	CALL_SIGNAL(3);
+	int result = 0;
+	if(foo_call(argc)
+		&& (CALL_SIGNAL(4), argc % 2 == 0))
+	{
+		CALL_SIGNAL(5);
+		result = 1;
+	}
+
+	return result;
+}
+
+__attribute__((noinline)) static int foo_inline(int c) {
+	INLINE_SIGNAL(0);
+	return c > 0
+		? (INLINE_SIGNAL(1), (c > 2))
+		: (INLINE_SIGNAL(2), (c - 1));
+}
+
+static int run_inline(int argc) {
+	INLINE_SIGNAL(3);
+	int result = 0;
+	if(foo_inline(argc)
+		&& (INLINE_SIGNAL(4), argc % 2 == 0))
+	{
+		INLINE_SIGNAL(5);
+		result = 1;
+	}
+
+	return result;
+}
+
+int main(int argc, const char** argv) {
+	unsigned long long iterations = bench_arg(argc, argv, 1, 100000000ULL);
+
+	BENCH_RUN("uninstrumented", iterations, g_sink = run_plain(g_input));
+	BENCH_RUN("call-based probes", iterations, g_sink = run_call(g_input));
+	BENCH_RUN("inline probes", iterations, g_sink = run_inline(g_input));
+
+#if ALLOW_DISABLE
+	moocov_disable();
+	BENCH_RUN("inline probes (disabled)", iterations, g_sink = run_inline(g_input));
+	moocov_enable();
+#endif
+
+	moocov_reset();
+	return 0;
+}
@@ -2,6 +2,7 @@
 #define MOOCOV_INSTRUMENTATION_H
 
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/DenseMap.h"
 
 #include <string>
 #include <set>
@@ -39,9 +40,11 @@ private:
 	std::string _getSignalInstrumentation(const Signal* sig, bool asStmt) const;
 
 	std::string _makeSignal(const Block* block);
-	std::string _makeImplicitSignal(const clang::CharSourceRange& range);
+
+	CounterExpression _getRegionCount(const Block* block) const;
 
 	void _instrumentStmtBlock(const Block* block, const InstrumentationContext& context);
+	void _instrumentLoopBlock(const Block* loopBlock, const InstrumentationContext& context);
 	void _instrumentExprBlock(const Block* exprBlock, const InstrumentationContext& context);
 
 public:
@@ -65,6 +68,14 @@ public:
 
 	void handleJumpStmt(const clang::Stmt* stmt, const InstrumentationContext& context);
 
+	/// \brief Gets the hit count of the code at the current point of the innermost Block, if it's known (see InstrumentationOptions::deriveCounters).
+	/// This is the hit count of the Block itself, until a jump or a label breaks up the flow of control in it.
+	CounterExpression getRegionCount(const InstrumentationContext& context) const;
+
+	/// \brief Makes a Block that is yet to begin a derived signal with the given hit count, instead of one with a counter.
+	/// Nothing happens if the count is unknown.
+	void deriveBlock(const Block* block, const CounterExpression& count);
+
 	bool redirectInclude(clang::FileID includedFileID, llvm::StringRef newFilePath);
 
 	void finalize();
@@ -80,6 +91,12 @@ private:
 
 	utils::FileRewriter m_rewriter;
 	SignalRegistry m_signals;
+
+	// the known hit counts of the code at the current point of the Blocks being instrumented
+	llvm::DenseMap<const Block*, CounterExpression> m_regionCounts;
+
+	// the hit counts of the Blocks that get derived signals, set by deriveBlock()
+	llvm::DenseMap<const Block*, CounterExpression> m_derivedCounts;
 };
 
 } // end namespace moocov
@@ -11,6 +11,34 @@
 
 namespace moocov {
 
+/// \brief Determines how the instrumented sources update the signal counters.
+/// The runtime has to be built with the matching mode (see moocovrt/runtime.h).
+enum class CounterMode {
+	/// \brief Plain increments: the fastest, but concurrent hits on the same signal may get lost.
+	Plain,
+
+	/// \brief Relaxed atomic increments (MOOCOV_ATOMIC_COUNTERS), safe to use from multiple threads.
+	Atomic,
+
+	/// \brief Per-thread copies of the counters (MOOCOV_SHARDED_COUNTERS), merged when dumping.
+	Sharded,
+
+	/// \brief Atomic increments on one of two swappable data buffers (MOOCOV_BUFFERED_COUNTERS), for dumping in the background.
+	Buffered
+};
+
+/// \brief Determines which constructs get signals of their own: each level also instruments everything the coarser ones do.
+enum class Granularity {
+	/// \brief Only the bodies of functions (and lambdas), to count how many times each of them was called.
+	Function,
+
+	/// \brief Also the statements that branch, loop or jump, and the code following jumps.
+	Block,
+
+	/// \brief Also the operands of conditional and short-circuit operators.
+	Expression
+};
+
 class InstrumentationOptions {
 public:
 	/// \brief The path to the directory where the instrumented source files should be stored.
@@ -29,6 +57,33 @@ public:
 	bool autoDumpAtExit;
 	std::set<std::string> excludedPaths;
 
+	CounterMode counterMode;
+
+	/// \brief Which constructs get signals. Anything coarser than Granularity::Expression is recorded in the map files.
+	Granularity granularity;
+
+	/// \brief If true, the data is moved into a memory-mapped file when first used (MOOCOV_MAPPED_COUNTERS), so that it survives crashes.
+	bool mappedCounters;
+
+	/// \brief If true, the data can be redirected by moocov_disable() (ALLOW_DISABLE).
+	bool allowDisable;
+
+	/// \brief If true, only whether each signal was hit is recorded (in byte-sized flags), instead of hit counters.
+	bool hitOnly;
+
+	/// \brief The width of the hit counters in bits: 8, 16, 32 or 64. Ignored if hitOnly is set.
+	unsigned counterWidth;
+
+	/// \brief If true, the hit counters stop at their maximum value instead of wrapping around.
+	bool saturatingCounters;
+
+	/// \brief If true, signals whose hit count follows from those of others (e.g. else branches) get no counters, and their counts are computed when reading the data instead.
+	/// This relies on the counters adding up exactly, so it's only used with full-width, wrapping hit counters.
+	bool deriveCounters;
+
+	/// \brief If true, the iterations of loops that can't leave the function are counted in local variables, and added to the counters after the loops.
+	bool localLoopCounters;
+
 	bool emitSources() const { return !omitSources; }
 	bool emitSignals() const { return !omitSignals; }
 
@@ -2,6 +2,9 @@
 #define MOOCOV_SIGNALREGISTRY_H
 
 #include <cassert>
+#include <map>
+#include <vector>
+#include <utility>
 
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/DenseMap.h"
@@ -9,6 +12,7 @@
 #include "clang/Basic/SourceManager.h"
 
 #include "moocov/utils/SourceFileRef.h"
+#include "moocov/InstrumentationOptions.h"
 
 namespace clang {
 
@@ -56,6 +60,30 @@ private:
 	bool m_isImplicit, m_isExceptional;
 };
 
+/// \brief The hit count of a piece of code, as a linear combination of the counters of signals.
+/// This is what lets a signal do without a counter of its own, if its hit count can be derived from those of other signals (see SignalRegistry::createDerivedSignal()).
+class CounterExpression {
+public:
+	/// \brief Signal index => coefficient.
+	using term_map = std::map<Signal::id_t, long>;
+
+	/// \brief Gets the hit count of a signal with a counter, or an unknown count if there's no signal.
+	static CounterExpression of(const Signal* signal);
+
+	/// \brief Creates an unknown count.
+	/*implicit*/ CounterExpression() = default;
+
+	bool isValid() const { return m_isValid; }
+	const term_map& getTerms() const { return m_terms; }
+
+	/// \brief Subtracts two counts. The result is unknown if either of them is.
+	CounterExpression operator-(const CounterExpression& rhs) const;
+
+private:
+	bool m_isValid = false;
+	term_map m_terms;
+};
+
 class SignalRegistry {
 public:
 	explicit SignalRegistry(utils::SourceFileRef sourceFile, const clang::LangOptions& langOpts)
@@ -73,7 +101,12 @@ public:
 
 	const Signal* createSignal(const clang::CharSourceRange& coveredRange, bool isImplicit, bool isExceptional);
 
-	bool writeTo(llvm::raw_ostream& os) const;
+	/// \brief Creates a signal without a counter, whose hit count is computed from the counters of other signals when reading the data.
+	/// Derived signals come after the ones with counters in the map file, and are not counted by size().
+	bool createDerivedSignal(const clang::CharSourceRange& coveredRange, bool isImplicit, bool isExceptional, const CounterExpression& count);
+
+	/// \brief Writes the map file. The granularity the signals were created with is recorded if it's coarser than Granularity::Expression.
+	bool writeTo(llvm::raw_ostream& os, Granularity granularity) const;
 
 private:
 	utils::SourceFileRef m_sourceFile;
@@ -81,6 +114,7 @@ private:
 	Signal::id_t m_nextId = 1; // id 0 is reserved as invalid
 
 	llvm::DenseMap<Signal::id_t, Signal> m_map;
+	std::vector<std::pair<Signal, CounterExpression>> m_derived;
 };
 
 } // end namespace moocov
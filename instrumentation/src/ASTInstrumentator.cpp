@@ -82,6 +82,15 @@ class InstrumentatorVisitor : public RecursiveASTVisitor<InstrumentatorVisitor>
 			&& !m_opts.isExcluded(m_sourceManager.getFilename(loc));
 	}
 
+	// whether statements and expressions get Blocks of their own, or only function bodies do (see InstrumentationOptions::granularity)
+	bool _instrumentsStmts() const {
+		return m_opts.granularity >= Granularity::Block;
+	}
+
+	bool _instrumentsExprs() const {
+		return m_opts.granularity >= Granularity::Expression;
+	}
+
 	void _initalizeFile(FileID fileID) {
 		utils::SourceFileRef file{m_sourceManager, fileID};
 
@@ -162,6 +171,26 @@ class InstrumentatorVisitor : public RecursiveASTVisitor<InstrumentatorVisitor>
 		return result;
 	}
 
+	// handles the two alternative Blocks of a conditional, either of which may be null
+	// if counters are derived, the second one gets no counter of its own: it runs whenever the code around the conditional does, but the first one doesn't
+	// the conditions of loops are traversed before the Blocks of the loops start, so the counts around them are per entry to the loop, not per iteration: those alternatives keep both counters
+	bool _handleAlternatives(Block* first, Block* second) {
+		if(!m_opts.deriveCounters || m_loopConditionDepth > 0 || !first || !second) {
+			return _handleBlock(first) && _handleBlock(second);
+		}
+
+		FileInstrumentation& instr = _getInstrumentation(first->getStmt()->getLocStart());
+		CounterExpression total = instr.getRegionCount(m_context);
+
+		_startBlock(first);
+		instr.deriveBlock(second, total - instr.getRegionCount(m_context));
+
+		bool result = TraverseStmt(const_cast<Stmt*>(first->getScope()));
+		_endBlock(first);
+
+		return result && _handleBlock(second);
+	}
+
 	// TODO: how label block handling works now causes FileInstrumentation::endBlock() to never get called for label blocks
 	// also, we leak all label blocks
 	// this will need to be re-designed properly
@@ -202,23 +231,30 @@ public:
 	bool TraverseStmt(Stmt* stmt) {
 		if(!stmt || !_shouldInstrument(stmt->getLocStart())) return true;
 
+		// with function granularity, only the bodies of lambdas within the statement get Blocks
+		if(!_instrumentsStmts()) return Base::TraverseStmt(stmt);
+
 		if(const Stmt* loopBody = getLoopBody(stmt)) {
 			if(const Stmt* loopCond = getLoopCond(stmt)) {
+				++m_loopConditionDepth;
 				TraverseStmt(const_cast<Stmt*>(loopCond));
+				--m_loopConditionDepth;
 			}
 
 			return _handleBlock(Block::createStmt(stmt, loopBody, m_context));
 		}
 
 		if(const auto condOp = dyn_cast<AbstractConditionalOperator>(stmt)) {
+			if(!_instrumentsExprs()) return Base::TraverseStmt(stmt);
+
 			Block* trueBlock, *falseBlock;
 			std::tie(trueBlock, falseBlock) = Block::createConditionalExpr(condOp, m_context);
 
-			return _handleBlock(trueBlock) && _handleBlock(falseBlock);
+			return _handleAlternatives(trueBlock, falseBlock);
 		}
 
 		if(const auto binOp = dyn_cast<BinaryOperator>(stmt)) {
-			if(binOp->isLogicalOp()) {
+			if(binOp->isLogicalOp() && _instrumentsExprs()) {
 				auto block = Block::createExpr(binOp, binOp->getRHS(), m_context);
 
 				_startBlock(block);
@@ -243,15 +279,19 @@ public:
 	}
 
 	bool TraverseIfStmt(IfStmt* stmt) {
+		if(!_instrumentsStmts()) return Base::TraverseIfStmt(stmt);
+
 		TraverseStmt(stmt->getCond());
 
 		Block* thenBlock, *elseBlock;
 		std::tie(thenBlock, elseBlock) = Block::createConditional(stmt, m_context);
 
-		return _handleBlock(thenBlock) && _handleBlock(elseBlock);
+		return _handleAlternatives(thenBlock, elseBlock);
 	}
 
 	bool TraverseCXXTryStmt(CXXTryStmt* tryStmt) {
+		if(!_instrumentsStmts()) return Base::TraverseCXXTryStmt(tryStmt);
+
 		_handleBlock(Block::createStmt(tryStmt, tryStmt->getTryBlock(), m_context));
 
 		for(unsigned i = 0; i < tryStmt->getNumHandlers(); ++i) {
@@ -267,10 +307,14 @@ public:
 	}
 
 	bool TraverseLabelStmt(LabelStmt* label) {
+		if(!_instrumentsStmts()) return Base::TraverseLabelStmt(label);
+
 		return _startLabelBlock(Block::createLabel(label, label->getSubStmt(), m_context));
 	}
 
 	bool TraverseSwitchStmt(SwitchStmt* switchStmt) {
+		if(!_instrumentsStmts()) return Base::TraverseSwitchStmt(switchStmt);
+
 		TraverseStmt(switchStmt->getCond());
 
 		// C++ switches are a little bit (very) crazy... I mean, have you seen Duff's machine?!
@@ -278,7 +322,8 @@ public:
 	}
 
 	bool VisitStmt(Stmt* stmt) {
-		if(isJumpStmt(stmt)) {
+		// the code after jumps only gets signals along with the other statements
+		if(isJumpStmt(stmt) && _instrumentsStmts()) {
 			_getInstrumentation(stmt->getLocStart()).handleJumpStmt(stmt, m_context);
 		}
 
@@ -298,6 +343,9 @@ private:
 	std::set<FileID> m_filesBeingInstrumented;
 	InstrumentationContext m_context;
 
+	// the number of loop conditions being traversed (see _handleAlternatives())
+	unsigned m_loopConditionDepth = 0;
+
 	const InstrumentationOptions& m_opts;
 	SourceManager& m_sourceManager;
 	const ASTContext& m_ASTContext;
@@ -1,8 +1,10 @@
 #include <system_error>
+#include <iterator>
 #include <cassert>
 
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/APSInt.h"
 
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Path.h"
@@ -37,12 +39,57 @@ FileInstrumentation::FileInstrumentation(const InstrumentationOptions& options,
 bool FileInstrumentation::_emitInstrumentationHeader() {
 	if(!hasSignals()) return false;
 
-	m_rewriter.insertToFileStart()
-		<< "#include \"moocovrt/runtime.h\"\n"
-		<< "MOOCOV_DEFINE_FILE("
-			<< m_sourceFile.getID() << ", "
-			<< m_signals.size()
-		<< ")\n";
+	DelayedString header = m_rewriter.insertToFileStart();
+
+	switch(m_options.counterMode) {
+	case CounterMode::Plain:
+		break;
+
+	case CounterMode::Atomic:
+		header << "#define MOOCOV_ATOMIC_COUNTERS 1\n";
+		break;
+
+	case CounterMode::Sharded:
+		header << "#define MOOCOV_SHARDED_COUNTERS 1\n";
+		break;
+
+	case CounterMode::Buffered:
+		header << "#define MOOCOV_ATOMIC_COUNTERS 1\n"
+			<< "#define MOOCOV_BUFFERED_COUNTERS 1\n";
+		break;
+	}
+
+	if(m_options.mappedCounters) {
+		header << "#define MOOCOV_MAPPED_COUNTERS 1\n";
+	}
+
+	if(m_options.allowDisable) {
+		header << "#define ALLOW_DISABLE 1\n";
+	}
+
+	header << "#include \"moocovrt/runtime.h\"\n";
+
+	if(m_options.hitOnly) {
+		header << "MOOCOV_DEFINE_FILE_EX("
+				<< m_sourceFile.getID() << ", "
+				<< m_signals.size() << ", "
+				<< "FLAGS"
+			<< ")\n";
+	} else if(m_options.counterWidth != 32 || m_options.saturatingCounters) {
+		// COUNTS, COUNTS8, COUNTS16 or COUNTS64, with a _SAT suffix if saturating
+		header << "MOOCOV_DEFINE_FILE_EX("
+				<< m_sourceFile.getID() << ", "
+				<< m_signals.size() << ", "
+				<< "COUNTS";
+		if(m_options.counterWidth != 32) header << m_options.counterWidth;
+		if(m_options.saturatingCounters) header << "_SAT";
+		header << ")\n";
+	} else {
+		header << "MOOCOV_DEFINE_FILE("
+				<< m_sourceFile.getID() << ", "
+				<< m_signals.size()
+			<< ")\n";
+	}
 
 	return true;
 }
@@ -51,8 +98,8 @@ std::string FileInstrumentation::_getSignalInstrumentation(const Signal* sig, bo
 	std::string signal;
 	llvm::raw_string_ostream os{signal};
 
-	os << "_moocov_signal("
-		<< "MOOCOV_FILEREF(" << m_sourceFile.getID() << "),"
+	os << "MOOCOV_SIGNAL("
+		<< m_sourceFile.getID() << ","
 		<< sig->getIndex()
 		<< ")";
 	if(asStmt) os << ";";
@@ -62,16 +109,55 @@ std::string FileInstrumentation::_getSignalInstrumentation(const Signal* sig, bo
 }
 
 std::string FileInstrumentation::_makeSignal(const Block* block) {
-	return _getSignalInstrumentation(
-		m_signals.createSignal(block->getCoverageRange(), false, block->isExceptional()),
-		!block->isExpr());
+	const Signal* signal = m_signals.createSignal(block->getCoverageRange(), false, block->isExceptional());
+	m_regionCounts[block] = CounterExpression::of(signal);
+
+	return _getSignalInstrumentation(signal, !block->isExpr());
+}
+
+CounterExpression FileInstrumentation::_getRegionCount(const Block* block) const {
+	auto it = m_regionCounts.find(block);
+	return it != m_regionCounts.end() ? it->second : CounterExpression{};
+}
+
+CounterExpression FileInstrumentation::getRegionCount(const InstrumentationContext& context) const {
+	return context.depth() != 0 ? _getRegionCount(context.getParent()) : CounterExpression{};
+}
+
+void FileInstrumentation::deriveBlock(const Block* block, const CounterExpression& count) {
+	if(count.isValid()) m_derivedCounts[block] = count;
 }
 
-std::string FileInstrumentation::_makeImplicitSignal(const CharSourceRange& range) {
-	return _getSignalInstrumentation(m_signals.createSignal(range, true, false), true);
+// Gets whether control can leave a statement other than by finishing it or by a break or continue, or enter it other than at its start.
+static bool hasNonLocalJumps(const Stmt* stmt, bool isInSwitch) {
+	if(!stmt) return false;
+
+	if(isa<ReturnStmt>(stmt)
+		|| isa<GotoStmt>(stmt)
+		|| isa<IndirectGotoStmt>(stmt)
+		|| isa<CXXThrowExpr>(stmt)
+		|| isa<LabelStmt>(stmt)
+		|| (isa<SwitchCase>(stmt) && !isInSwitch)) {
+		return true;
+	}
+
+	// the returns in a lambda leave the lambda only
+	if(isa<LambdaExpr>(stmt)) return false;
+
+	isInSwitch = isInSwitch || isa<SwitchStmt>(stmt);
+	for(const Stmt* child : stmt->children()) {
+		if(hasNonLocalJumps(child, isInSwitch)) return true;
+	}
+
+	return false;
 }
 
 void FileInstrumentation::_instrumentStmtBlock(const Block* block, const InstrumentationContext& context) {
+	if(m_options.localLoopCounters && block->isLoop() && !hasNonLocalJumps(block->getStmt(), false)) {
+		_instrumentLoopBlock(block, context);
+		return;
+	}
+
 	std::string instrumentation = _makeSignal(block);
 
 	if(block->getScopeAs<CompoundStmt>() || block->isLabel()) {
@@ -79,8 +165,40 @@ void FileInstrumentation::_instrumentStmtBlock(const Block* block, const Instrum
 		m_rewriter.insert(block->getCoverageStartLoc(), instrumentation);
 	} else {
 		// wrap it in a CompoundStmt and do the instrumentation
+		// the end goes before anything the parent Blocks have inserted there, like the counter flushes of loops (see _instrumentLoopBlock())
 		m_rewriter.insert(block->getCoverageStartLoc()) << "{" << instrumentation;
-		m_rewriter.insert(block->getCoverageEndLoc()) << "}";
+		m_rewriter.insertBefore(block->getCoverageEndLoc(), "}");
+	}
+}
+
+void FileInstrumentation::_instrumentLoopBlock(const Block* loopBlock, const InstrumentationContext& context) {
+	const Signal* signal = m_signals.createSignal(loopBlock->getCoverageRange(), false, false);
+	m_regionCounts[loopBlock] = CounterExpression::of(signal);
+
+	// the loop gets wrapped in a CompoundStmt declaring the iteration counter, which the compiler can keep in a register
+	BUILD_STR(counter, 32) << "_moocov_iterations" << signal->getIndex();
+	BUILD_STR(flush, 64) << "MOOCOV_SIGNAL_N("
+			<< m_sourceFile.getID() << ","
+			<< signal->getIndex() << ","
+			<< counter
+		<< ");}";
+
+	m_rewriter.insert(loopBlock->getLocBefore()) << "{moocov_data_size_t " << counter << " = 0;";
+
+	// the counter is flushed before anything that a parent Block has already inserted after the loop (e.g. the end of its own CompoundStmt), and after the ends of the Blocks in the body, which are inserted before it later
+	SourceLocation bodyEndLoc = loopBlock->getCoverageEndLoc(), loopEndLoc = loopBlock->getLocAfter();
+	if(loopBlock->getScopeAs<CompoundStmt>()) {
+		m_rewriter.insert(loopBlock->getCoverageStartLoc()) << "++" << counter << ";";
+		m_rewriter.insertBefore(loopEndLoc, flush);
+	} else {
+		m_rewriter.insert(loopBlock->getCoverageStartLoc()) << "{++" << counter << ";";
+
+		if(bodyEndLoc == loopEndLoc) {
+			m_rewriter.insertBefore(loopEndLoc) << "}" << flush;
+		} else {
+			m_rewriter.insertBefore(bodyEndLoc, "}");
+			m_rewriter.insertBefore(loopEndLoc, flush);
+		}
 	}
 }
 
@@ -114,6 +232,20 @@ void FileInstrumentation::endFunction(const FunctionDecl* func) {
 
 }
 
+// Gets whether a Block is entered exactly as many times as the code around it runs, so that it can share its hit count instead of having a signal of its own.
+static bool isEnteredWithParent(const Block* block, const ASTContext& astContext) {
+	// try blocks (but not catch blocks)
+	if(block->getStmtAs<CXXTryStmt>()) return true;
+
+	// do { ... } while(0)
+	if(const auto doStmt = block->getStmtAs<DoStmt>()) {
+		llvm::APSInt cond;
+		return doStmt->getCond()->EvaluateAsInt(cond, astContext) && cond == 0;
+	}
+
+	return false;
+}
+
 void FileInstrumentation::beginBlock(const Block* block, const InstrumentationContext& context) {
 	if(block->isFunctionBody()) {
 		const FunctionDecl* func = context.getCurrentFunction();
@@ -124,9 +256,31 @@ void FileInstrumentation::beginBlock(const Block* block, const InstrumentationCo
 				m_rewriter.insert(block->getCoverageStartLoc(), "{atexit(moocov_dump);}");
 			}
 		}
+	}
+
+	if(block->isLabel()) {
+		// a label can be jumped to from anywhere, so the code following it in any of the enclosing Blocks may run any number of times
+		// switch cases can only be jumped to from their switch statement, so we can stop there
+		for(const Block* parent : context.parents()) {
+			m_regionCounts.erase(parent);
+			if(isa<SwitchCase>(block->getStmt()) && parent->getStmtAs<SwitchStmt>()) break;
+		}
+	}
 
-		m_rewriter.insert(block->getCoverageStartLoc())
-			<< "_moocov_link(MOOCOV_FILEREF(" << m_sourceFile.getID() << "));";
+	if(m_options.deriveCounters && isEnteredWithParent(block, m_astContext)) {
+		deriveBlock(block, getRegionCount(context));
+	}
+
+	auto derivedIt = m_derivedCounts.find(block);
+	if(derivedIt != m_derivedCounts.end()) {
+		CounterExpression count = derivedIt->second;
+		m_derivedCounts.erase(derivedIt);
+
+		if(m_signals.createDerivedSignal(block->getCoverageRange(), false, block->isExceptional(), count)) {
+			// nothing to insert: the hit count is computed from the counters of other signals
+			m_regionCounts[block] = count;
+			return;
+		}
 	}
 
 	if(block->isExpr()) {
@@ -145,7 +299,7 @@ static const Stmt* findContainingStmt(const Stmt* stmt, const ASTContext& contex
 	// ... gets transformed to:
 	// decltype(foo()) ___fooresult;
 	// decltype(bar()) ___barresult;
-	// (___fooresult = foo(), (_moocov_signal(), ___fooresult)) + (___barresult = bar(), (_moocov_signal(), ___barresult))
+	// (___fooresult = foo(), (MOOCOV_SIGNAL(), ___fooresult)) + (___barresult = bar(), (MOOCOV_SIGNAL(), ___barresult))
 	// But even this doesn't work always. E.g. in class member initializers. Or in cases when decltype(foo()) is not default-constructible.
 	// What works is creating a proxy function, but that involves an extra copy or move of the result anyway, which may not always be possible.
 
@@ -184,6 +338,14 @@ void FileInstrumentation::handleJumpStmt(const Stmt* stmt, const Instrumentation
 				// if we're calling a function, and we can assume that it won't exit or throw an exception, then it's not a jump we care about
 				return;
 			}
+
+			// a call that never returns (e.g. exit() or longjmp()) leaves every Block around it, so the code after it doesn't run as many times as the code before it did
+			// calls that only might throw or exit are assumed to return, as otherwise hardly any counters could be derived
+			if(callee->isNoReturn()) {
+				for(const Block* block : context.parents()) {
+					m_regionCounts.erase(block);
+				}
+			}
 		}
 
 		return; // TODO - remove once we can handle function calls properly
@@ -201,6 +363,17 @@ void FileInstrumentation::handleJumpStmt(const Stmt* stmt, const Instrumentation
 	}
 	assert(handlerBlock && "Could not find handler block for jump!");
 
+	// the jump is taken every time the code around it runs, so it leaves the code following it in every Block up to the handler with an unknown hit count
+	CounterExpression jumpCount = _getRegionCount(containingBlock);
+	for(const Block* block : context.parents()) {
+		m_regionCounts.erase(block);
+		if(block == handlerBlock) break;
+	}
+
+	// the Block that the implicit signal starts the rest of, and its hit count before the jump
+	const Block* implicitBlock = nullptr;
+	CounterExpression countBefore;
+
 	SourceLocation implicitScopeLocStart;
 	if(handlerBlock == containingBlock) {
 		// if the jump statement is directly inside the Block that it refers to (e.g. return is directly inside the function body, or continue directly inside a loop), then the implicit block will start right after the statement containing the jump
@@ -208,16 +381,39 @@ void FileInstrumentation::handleJumpStmt(const Stmt* stmt, const Instrumentation
 		if(!containingStmt) return;
 
 		implicitScopeLocStart = utils::getStmtEndLoc(containingStmt, context.getSourceManager(), context.getLangOpts());
+
+		implicitBlock = containingBlock;
+		countBefore = jumpCount;
 	} else {
 		// otherwise the implicit block will start directly after the containing block for the jump
 		implicitScopeLocStart = containingBlock->getLocAfter();
+
+		// that is in the enclosing Block, except for labels and expressions, which end somewhere else
+		if(!containingBlock->isLabel() && !containingBlock->isExpr()) {
+			implicitBlock = *std::next(context.parents_begin());
+			countBefore = _getRegionCount(implicitBlock);
+		}
 	}
 
-	std::string instr = _makeImplicitSignal(CharSourceRange::getCharRange(implicitScopeLocStart, handlerBlock->getCoverageEndLoc()));
-	m_rewriter.insert(implicitScopeLocStart, instr);
+	CharSourceRange implicitRange = CharSourceRange::getCharRange(implicitScopeLocStart, handlerBlock->getCoverageEndLoc());
+
+	// the code after the jump runs as many times as the code before it did, minus the jumps
+	if(m_options.deriveCounters && implicitBlock) {
+		CounterExpression implicitCount = countBefore - jumpCount;
+		if(m_signals.createDerivedSignal(implicitRange, true, false, implicitCount)) {
+			m_regionCounts[implicitBlock] = implicitCount;
+			return;
+		}
+	}
+
+	const Signal* signal = m_signals.createSignal(implicitRange, true, false);
+	if(implicitBlock) m_regionCounts[implicitBlock] = CounterExpression::of(signal);
+
+	m_rewriter.insert(implicitScopeLocStart, _getSignalInstrumentation(signal, true));
 }
 
 void FileInstrumentation::endBlock(const Block* block, const InstrumentationContext& context) {
+	m_regionCounts.erase(block);
 }
 
 bool FileInstrumentation::redirectInclude(FileID includedFileID, llvm::StringRef newFilePath) {
@@ -263,7 +459,7 @@ bool FileInstrumentation::_outputSignals(llvm::StringRef outputFilename) {
 
 	if(m_options.outputSignalsToStdout()) {
 		llvm::outs() << "\n$$Signals:\n\n";
-		m_signals.writeTo(llvm::outs());
+		m_signals.writeTo(llvm::outs(), m_options.granularity);
 	} else {
 		BUILD_STR(outputPath, 64)
 			<< m_options.signalsOutputDirectory
@@ -277,7 +473,7 @@ bool FileInstrumentation::_outputSignals(llvm::StringRef outputFilename) {
 			return false;
 		}
 
-		m_signals.writeTo(os);
+		m_signals.writeTo(os, m_options.granularity);
 		os.close();
 	}
 
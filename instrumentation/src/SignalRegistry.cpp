@@ -1,4 +1,5 @@
 #include <tuple>
+#include <cstdlib>
 
 #include "llvm/Support/raw_ostream.h"
 
@@ -23,6 +24,28 @@ Signal Signal::create(id_t id, const SourceManager& sources, const CharSourceRan
 	};
 }
 
+CounterExpression CounterExpression::of(const Signal* signal) {
+	CounterExpression result;
+	if(signal) {
+		result.m_isValid = true;
+		result.m_terms[signal->getIndex()] = 1;
+	}
+
+	return result;
+}
+
+CounterExpression CounterExpression::operator-(const CounterExpression& rhs) const {
+	if(!m_isValid || !rhs.m_isValid) return {};
+
+	CounterExpression result = *this;
+	for(const auto& term : rhs.m_terms) {
+		long coefficient = result.m_terms[term.first] -= term.second;
+		if(coefficient == 0) result.m_terms.erase(term.first);
+	}
+
+	return result;
+}
+
 const Signal* SignalRegistry::createSignal(const CharSourceRange& coveredRange, bool isImplicit, bool isExceptional) {
 	if(coveredRange.isInvalid()) return nullptr;
 
@@ -36,7 +59,15 @@ const Signal* SignalRegistry::createSignal(const CharSourceRange& coveredRange,
 	return &(it->second);
 }
 
-bool SignalRegistry::writeTo(llvm::raw_ostream& os) const {
+bool SignalRegistry::createDerivedSignal(const CharSourceRange& coveredRange, bool isImplicit, bool isExceptional, const CounterExpression& count) {
+	if(coveredRange.isInvalid() || !count.isValid()) return false;
+
+	// the ID is only used to tell it apart from an invalid Signal: the index is assigned when writing the map
+	m_derived.push_back(std::make_pair(Signal::create(m_derived.size() + 1, m_sourceFile.getSourceManager(), coveredRange, isImplicit, isExceptional), count));
+	return true;
+}
+
+bool SignalRegistry::writeTo(llvm::raw_ostream& os, Granularity granularity) const {
 	if(empty()) return false;
 
 	using moocov::utils::fastInt;
@@ -55,6 +86,44 @@ bool SignalRegistry::writeTo(llvm::raw_ostream& os) const {
 			<< fastInt << signal.getEndLoc().getExpansionColumnNumber() << "\n";
 	}
 
+	// coarser maps say so, so that readers know that the signals don't tell apart the lines they cover
+	if(granularity == Granularity::Function) {
+		os << "%function\n";
+	} else if(granularity == Granularity::Block) {
+		os << "%block\n";
+	}
+
+	// the derived signals: the same as above, followed by the terms of the hit count, each one added or subtracted once
+	if(!m_derived.empty()) {
+		os << "=" << fastInt << m_derived.size() << "\n";
+
+		Signal::id_t index = size();
+		for(const auto& derived : m_derived) {
+			const Signal& signal = derived.first;
+			const CounterExpression::term_map& terms = derived.second.getTerms();
+
+			unsigned long numTerms = 0;
+			for(const auto& term : terms) {
+				numTerms += std::abs(term.second);
+			}
+
+			os << fastInt << index++ << " "
+				<< fastInt << signal.getBeginLoc().getExpansionLineNumber() << " "
+				<< fastInt << signal.getBeginLoc().getExpansionColumnNumber() << " "
+				<< fastInt << signal.getEndLoc().getExpansionLineNumber() << " "
+				<< fastInt << signal.getEndLoc().getExpansionColumnNumber() << " "
+				<< fastInt << numTerms;
+
+			for(const auto& term : terms) {
+				for(long i = 0; i < std::abs(term.second); ++i) {
+					os << (term.second > 0 ? " +" : " -") << fastInt << term.first;
+				}
+			}
+
+			os << "\n";
+		}
+	}
+
 	return true;
 }
 
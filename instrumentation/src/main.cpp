@@ -65,6 +65,72 @@ static cl::opt<bool> g_autoDumpAtExit{"auto-dump",
 	cl::cat(g_myToolCategory)
 };
 
+static cl::opt<moocov::CounterMode> g_counterMode{"counters",
+	cl::desc("How the instrumented sources should update the signal counters (the runtime has to be built with the same mode)"),
+	cl::values(
+		clEnumValN(moocov::CounterMode::Plain, "plain", "Plain increments: the fastest, but not thread-safe"),
+		clEnumValN(moocov::CounterMode::Atomic, "atomic", "Relaxed atomic increments, for multi-threaded programs"),
+		clEnumValN(moocov::CounterMode::Sharded, "sharded", "Per-thread copies of the counters, for heavily multi-threaded programs"),
+		clEnumValN(moocov::CounterMode::Buffered, "buffered", "Atomic increments on double-buffered counters, for multi-threaded programs dumped in the background"),
+		clEnumValEnd),
+	cl::init(moocov::CounterMode::Plain),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<moocov::Granularity> g_granularity{"granularity",
+	cl::desc("Which constructs should get signals (coarser ones make the instrumented code faster)"),
+	cl::values(
+		clEnumValN(moocov::Granularity::Function, "function", "Only function bodies: just count the calls of each function"),
+		clEnumValN(moocov::Granularity::Block, "block", "Also branches, loops and the code after jumps"),
+		clEnumValN(moocov::Granularity::Expression, "expr", "Also the operands of conditional and short-circuit operators"),
+		clEnumValEnd),
+	cl::init(moocov::Granularity::Expression),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<bool> g_mappedCounters{"mapped-counters",
+	cl::desc("Keep the data in a memory-mapped file, so that it persists even if the program crashes (the runtime has to be built with the same mode)"),
+	cl::init(false),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<bool> g_allowDisable{"allow-disable",
+	cl::desc("Let moocov_disable() stop the data gathering (the runtime has to be built with -DALLOW_DISABLE=1 too)"),
+	cl::init(false),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<bool> g_hitOnly{"hit-only",
+	cl::desc("Only record whether each signal was hit, not how many times"),
+	cl::init(false),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<unsigned> g_counterWidth{"counter-width",
+	cl::desc("The width of the hit counters in bits: 8, 16, 32 or 64 (narrower counters take less memory and cache, but wrap around sooner)"),
+	cl::value_desc("bits"),
+	cl::init(32),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<bool> g_saturatingCounters{"saturating",
+	cl::desc("Make the hit counters stop at their maximum value instead of wrapping around to 0"),
+	cl::init(false),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<bool> g_deriveCounters{"derive-counters",
+	cl::desc("Don't give counters to signals whose hit count can be computed from those of others (e.g. else branches), which makes the instrumented code faster (the computed counts assume that calls return, unless the called function is declared noreturn)"),
+	cl::init(false),
+	cl::cat(g_myToolCategory)
+};
+
+static cl::opt<bool> g_localLoopCounters{"local-loop-counters",
+	cl::desc("Count the iterations of loops in local variables, and add them to the counters once the loops are done (loops with return, goto or throw statements are left alone)"),
+	cl::init(false),
+	cl::cat(g_myToolCategory)
+};
+
 static cl::opt<bool> g_omitSignals{"omit-maps",
 	cl::desc("Don't output mapping files"),
 	cl::init(false),
@@ -109,6 +175,26 @@ static bool populateOptions(moocov::InstrumentationOptions& opts) {
 	}
 
 	opts.autoDumpAtExit = g_autoDumpAtExit;
+	opts.counterMode = g_counterMode;
+	opts.granularity = g_granularity;
+	opts.mappedCounters = g_mappedCounters;
+	opts.allowDisable = g_allowDisable;
+	opts.hitOnly = g_hitOnly;
+	opts.counterWidth = g_counterWidth;
+	opts.saturatingCounters = g_saturatingCounters;
+	opts.localLoopCounters = g_localLoopCounters;
+
+	if(opts.counterWidth != 8 && opts.counterWidth != 16 && opts.counterWidth != 32 && opts.counterWidth != 64) {
+		llvm::errs() << "Error: invalid counter width " << opts.counterWidth << " - it has to be 8, 16, 32 or 64.\n";
+		return false;
+	}
+
+	// derived hit counts are differences of counters, which are only right if the counters hold the exact counts
+	opts.deriveCounters = g_deriveCounters;
+	if(opts.deriveCounters && (opts.hitOnly || opts.saturatingCounters || opts.counterWidth < 32)) {
+		llvm::errs() << "Warning: --derive-counters needs full hit counters of at least 32 bits without --saturating - not deriving any.\n";
+		opts.deriveCounters = false;
+	}
 
 	// make any exclusion paths absolute
 	for(const std::string& excl : g_excludes) {
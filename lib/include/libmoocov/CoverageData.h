@@ -6,20 +6,28 @@
 #include <tuple>
 #include <cassert>
 #include <string>
+#include <limits>
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
 
 #include "libmoocov/Core.h"
 
 namespace libmoocov {
 
+struct SignalMap;
+
 /// \brief Represents the coverage data belonging to a FileID.
 class FileCoverage {
 public:
-	explicit FileCoverage(FileID fileID) : m_fileID{fileID} {}
+	explicit FileCoverage(FileID fileID, bool isHitOnly = false) : m_fileID{fileID}, m_isHitOnly{isHitOnly} {}
 
 	FileID getFileID() const { return m_fileID; }
 
+	/// \brief Whether only the fact that the signals were hit is known, but not how many times.
+	/// In this case, all hit counters are either 0 or 1.
+	bool isHitOnly() const { return m_isHitOnly; }
+
 	void setHitCount(signalid_t signalID, std::size_t count);
 	std::size_t addHitCount(signalid_t signalID, std::size_t count);
 
@@ -28,9 +36,15 @@ public:
 		return it == m_counters.end() ? 0 : it->second;
 	}
 
+	/// \brief The hit counters of the signals that were hit, by signal ID.
+	const std::map<signalid_t, std::size_t>& getHitCounts() const { return m_counters; }
+
 	void update(const FileCoverage& other) {
 		assert(m_fileID == other.m_fileID);
 
+		// if the same file was also built with hit counters, we just treat everything as hit counters
+		m_isHitOnly = m_isHitOnly && other.m_isHitOnly;
+
 		for(const auto& pair : other.m_counters) {
 			addHitCount(pair.first, pair.second);
 		}
@@ -38,6 +52,7 @@ public:
 
 private:
 	FileID m_fileID;
+	bool m_isHitOnly;
 
 	// signal ID => hit counter
 	std::map<signalid_t, std::size_t> m_counters;
@@ -65,7 +80,28 @@ public:
 
 	void addFileCoverage(const FileCoverage& data);
 
-	bool read(const std::string& filePath);
+	/// \brief Adds the data of another aggregate to this one.
+	void update(const CoverageData& other);
+
+	/// \brief Passed to read() to read every dump of a data file.
+	static constexpr std::size_t allDumps = std::numeric_limits<std::size_t>::max();
+
+	/// \brief Reads the first numDumps dumps of a data file, adding them to the data read so far.
+	/// Each dump holds the hits since the previous one, so this gives the data as it was when the last of them was made.
+	/// A counter file of MOOCOV_MAPPED_COUNTERS mode counts as a single dump.
+	bool read(const std::string& filePath, std::size_t numDumps = allDumps);
+
+	/// \brief Reads the contents of a data file (or a counter file of MOOCOV_MAPPED_COUNTERS mode) that are already in memory.
+	/// The buffer may be the counter file of a running program, mapped into memory.
+	bool readBuffer(llvm::StringRef data, std::size_t numDumps = allDumps);
+
+	/// \brief Reads every dump of a data file, adding the hits of each to the data of the context it belongs to (see moocov_set_context()), by name.
+	/// The hits dumped while no context was active are added to the data of the empty name.
+	static bool readContexts(const std::string& filePath, std::map<std::string, CoverageData>& contexts);
+
+	/// \brief Adds the hit counts of the signals of a map that don't have counters (see SignalMap::derivedSignals), computed from the data read so far.
+	/// Call it once for each map, after all the data has been read.
+	void addDerivedHitCounts(const SignalMap& map);
 
 private:
 	std::set<FileID> m_files;
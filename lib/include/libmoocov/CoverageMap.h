@@ -4,6 +4,9 @@
 #include <tuple>
 #include <string>
 #include <set>
+#include <map>
+#include <vector>
+#include <utility>
 #include <cassert>
 
 #include "llvm/ADT/DenseMap.h"
@@ -53,12 +56,32 @@ struct SignalMapping {
 /// \brief Represents an ordered set of SignalMapping-s, potentially from different FileIDs (and potentially having signals that cover the exact same source range).
 using SignalSet = std::set<SignalMapping, SignalMapping::CompareByRange>;
 
+/// \brief The hit count of a signal without a counter of its own (see moocov-instrument --derive-counters): the sum of the hit counts of other signals of the same FileID, each multiplied by a coefficient.
+using CounterExpression = std::vector<std::pair<signalid_t, long>>;
+
+/// \brief Which constructs the signals of a map were created for (see moocov-instrument --granularity).
+enum class Granularity {
+	/// \brief Only function bodies: their signals tell how many times the functions were called, but not which of their lines ran.
+	Function,
+
+	/// \brief Statements, but not the operands of conditional and short-circuit operators.
+	Block,
+
+	/// \brief Everything.
+	Expression
+};
+
 /// \brief A simple structure representing the mapping information of a single FileID.
 struct SignalMap {
 	FileID fileID;
 	std::string sourceFilePath;
 	llvm::DenseMap<signalid_t, SignalMapping> signals;
 
+	/// \brief The hit counts of the signals (also in signals) that don't have counters, by signal ID (see CoverageData::addDerivedHitCounts()).
+	llvm::DenseMap<signalid_t, CounterExpression> derivedSignals;
+
+	Granularity granularity = Granularity::Expression;
+
 	/*implicit*/ SignalMap() = default;
 
 	explicit SignalMap(FileID fileID_, const std::string& sourceFilePath_)
@@ -76,6 +99,8 @@ struct SignalMap {
 		fileID = FileID{};
 		sourceFilePath = "";
 		signals.clear();
+		derivedSignals.clear();
+		granularity = Granularity::Expression;
 	}
 };
 
@@ -99,6 +124,12 @@ public:
 		return m_files.find(id) != m_files.end();
 	}
 
+	/// \brief Gets the granularity of the signals of the given FileID.
+	Granularity getGranularity(FileID id) const {
+		auto it = m_granularities.find(id);
+		return it != m_granularities.end() ? it->second : Granularity::Expression;
+	}
+
 	const SignalMapping* getSignal(FileID fileID, signalid_t signalID) const {
 		for(const SignalMapping& signal : m_signals) {
 			if(signal.id == signalID && signal.fileID == fileID) {
@@ -114,6 +145,7 @@ public:
 		assert(m_path == map.sourceFilePath);
 
 		m_files.insert(map.fileID);
+		m_granularities[map.fileID] = map.granularity;
 
 		for(const auto& pair : map.signals) {
 			m_signals.insert(pair.second);
@@ -123,6 +155,7 @@ public:
 private:
 	std::string m_path;
 	std::set<FileID> m_files;
+	std::map<FileID, Granularity> m_granularities;
 	SignalSet m_signals;
 };
 
@@ -30,7 +30,10 @@ bool tryParseFastInteger(llvm::StringRef str, T& n) {
 
 template<typename T>
 inline T& parseFastInteger(llvm::StringRef str, T& n) {
-	assert(tryParseFastInteger(str, n));
+	bool ok = tryParseFastInteger(str, n);
+	assert(ok && "Invalid number!");
+	(void)ok;
+
 	return n;
 }
 
@@ -1,6 +1,14 @@
-#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "moocovrt/dumpformat.h"
 
 #include "libmoocov/utils/fastint.h"
+#include "libmoocov/CoverageMap.h"
 #include "libmoocov/CoverageData.h"
 
 namespace libmoocov {
@@ -19,6 +27,11 @@ std::size_t FileCoverage::addHitCount(signalid_t signalID, std::size_t count) {
 	std::tie(it, inserted) = m_counters.insert(std::make_pair(signalID, count));
 
 	if(!inserted) {
+		if(m_isHitOnly) {
+			// merging hit flags: the signal was hit if it was hit in either
+			return it->second = std::max(it->second, count);
+		}
+
 		return it->second += count;
 	}
 	return count;
@@ -34,33 +47,325 @@ void CoverageData::addFileCoverage(const FileCoverage& data) {
 	else it->second.update(data);
 }
 
-bool CoverageData::read(const std::string& filePath) {
-	std::ifstream fs{filePath.c_str()};
-	if(!fs) return false;
+void CoverageData::update(const CoverageData& other) {
+	for(const auto& pair : other.m_data) {
+		addFileCoverage(pair.second);
+	}
+}
+
+void CoverageData::addDerivedHitCounts(const SignalMap& map) {
+	if(map.derivedSignals.empty()) return;
+
+	// if none of the signals of the file were hit, neither were the derived ones
+	auto it = m_data.find(map.fileID);
+	if(it == m_data.end()) return;
+
+	FileCoverage& cov = it->second;
+	for(const auto& pair : map.derivedSignals) {
+		long long count = 0;
+		for(const auto& term : pair.second) {
+			count += term.second * static_cast<long long>(cov.getHitCount(term.first));
+		}
+
+		// the counters of a running program may be read while they're being incremented, so they might not add up exactly
+		if(count > 0) cov.setHitCount(pair.first, static_cast<std::size_t>(count));
+	}
+}
+
+// Gets the data that the hits of a dump belonging to a context (see moocov_set_context()) are added to. The context is empty for dumps without one.
+using ContextSelector = llvm::function_ref<CoverageData&(llvm::StringRef context)>;
+
+// Whether the data starts with a dump in the binary format.
+static bool isBinaryDump(llvm::StringRef data) {
+	return data.startswith(llvm::StringRef{MOOCOV_DUMP_MAGIC, MOOCOV_DUMP_MAGIC_LENGTH});
+}
+
+// Reads a value written by the runtime in its own byte order, and advances past it.
+template<typename T>
+static bool readValue(llvm::StringRef& data, T& value) {
+	if(data.size() < sizeof(T)) return false;
+
+	std::memcpy(&value, data.data(), sizeof(T));
+	data = data.drop_front(sizeof(T));
+	return true;
+}
+
+// Reads a counter (or flag) of the width of the given kind, and advances past it.
+static bool readCounter(llvm::StringRef& data, uint8_t kind, std::size_t& value) {
+	uint8_t value8;
+	uint16_t value16;
+	uint32_t value32;
+	uint64_t value64;
+
+	switch(kind & ~MOOCOV_KIND_SATURATING) {
+	case MOOCOV_KIND_FLAGS:
+	case MOOCOV_KIND_COUNTS8:
+		if(!readValue(data, value8)) return false;
+		value = value8;
+		return true;
+
+	case MOOCOV_KIND_COUNTS16:
+		if(!readValue(data, value16)) return false;
+		value = value16;
+		return true;
+
+	case MOOCOV_KIND_COUNTS:
+		if(!readValue(data, value32)) return false;
+		value = value32;
+		return true;
+
+	case MOOCOV_KIND_COUNTS64:
+		if(!readValue(data, value64)) return false;
+		value = static_cast<std::size_t>(value64);
+		return true;
+
+	default:
+		// a kind of a newer runtime
+		return false;
+	}
+}
+
+// Reads a varint (see MOOCOV_DUMP_RUNS), and advances past it.
+static bool readVarint(llvm::StringRef& data, uint64_t& value) {
+	value = 0;
 
-	FileID fileID;
+	for(unsigned shift = 0; shift < 64 && !data.empty(); shift += 7) {
+		uint8_t byte = static_cast<uint8_t>(data.front());
+		data = data.drop_front();
+
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if(!(byte & 0x80)) return true;
+	}
+
+	return false;
+}
+
+// Reads a MOOCOV_DUMP_RUNS payload.
+static bool readRuns(llvm::StringRef& data, const moocov_dump_file_t& entry, FileCoverage& cov) {
+	uint64_t signalID = 0, gap, length, hitCount = 1;
+
+	for(uint32_t i = 0; i < entry.numRecords; ++i) {
+		if(!readVarint(data, gap) || !readVarint(data, length)) return false;
+
+		signalID += gap;
+		if(signalID > entry.numSignals || length > entry.numSignals - signalID) return false;
+
+		for(uint64_t end = signalID + length; signalID < end; ++signalID) {
+			if(!cov.isHitOnly() && !readVarint(data, hitCount)) return false;
+
+			cov.setHitCount(static_cast<signalid_t>(signalID), static_cast<std::size_t>(hitCount));
+		}
+	}
+
+	return true;
+}
+
+// Reads the payload of a file table entry of a binary dump.
+static bool readPayload(llvm::StringRef& data, const moocov_dump_file_t& entry, FileCoverage& cov) {
+	uint32_t signalID;
+	std::size_t hitCount;
+
+	if(entry.encoding == MOOCOV_DUMP_DENSE) {
+		for(signalID = 0; signalID < entry.numSignals; ++signalID) {
+			if(!readCounter(data, entry.kind, hitCount)) return false;
+			if(cov.isHitOnly()) hitCount = hitCount != 0;
+
+			if(hitCount != 0) cov.setHitCount(signalID, hitCount);
+		}
+
+		return true;
+	}
+
+	if(entry.encoding == MOOCOV_DUMP_RUNS) return readRuns(data, entry, cov);
+	if(entry.encoding != MOOCOV_DUMP_SPARSE) return false;
+
+	for(uint32_t i = 0; i < entry.numRecords; ++i) {
+		if(!readValue(data, signalID)) return false;
+
+		if(cov.isHitOnly()) {
+			hitCount = 1;
+		} else if(!readCounter(data, entry.kind, hitCount)) {
+			return false;
+		}
+
+		cov.setHitCount(signalID, hitCount);
+	}
+
+	return true;
+}
+
+// Reads a dump in the binary format (see moocovrt/dumpformat.h).
+static bool readBinaryDump(llvm::StringRef& data, ContextSelector selectContext) {
+	moocov_dump_header_t header;
+	if(!readValue(data, header)) return false;
+
+	llvm::StringRef context;
+	if(header.version == MOOCOV_DUMP_VERSION) {
+		uint32_t contextLength;
+		if(!readValue(data, contextLength) || data.size() < contextLength) return false;
+
+		context = data.substr(0, contextLength);
+		data = data.drop_front(contextLength);
+	} else if(header.version != MOOCOV_DUMP_VERSION_WITHOUT_CONTEXT) {
+		return false;
+	}
+
+	CoverageData& coverage = selectContext(context);
+
+	std::vector<moocov_dump_file_t> table(header.numFiles);
+	for(moocov_dump_file_t& entry : table) {
+		if(!readValue(data, entry)) return false;
+	}
+
+	if(data.size() < header.idTableSize) return false;
+
+	llvm::StringRef ids = data.substr(0, header.idTableSize);
+	data = data.drop_front(header.idTableSize);
+
+	for(const moocov_dump_file_t& entry : table) {
+		if(static_cast<std::size_t>(entry.idOffset) + entry.idLength > ids.size()) return false;
+
+		FileCoverage cov{FileID::parse(ids.substr(entry.idOffset, entry.idLength)), entry.kind == MOOCOV_KIND_FLAGS};
+		if(!readPayload(data, entry, cov)) return false;
+
+		coverage.addFileCoverage(cov);
+	}
+
+	return true;
+}
+
+// Reads a counter file of MOOCOV_MAPPED_COUNTERS mode (see moocovrt/dumpformat.h).
+// The program may have crashed while writing it, so anything incomplete after the first chunk header is ignored.
+static bool readMappedCounters(llvm::StringRef data, CoverageData& coverage) {
+	moocov_mapped_chunk_t chunkHeader;
+	moocov_mapped_file_t record;
+	moocov_dump_file_t entry;
+
+	bool isFirstChunk = true;
+	while(data.startswith(llvm::StringRef{MOOCOV_MAPPED_MAGIC, MOOCOV_MAPPED_MAGIC_LENGTH})) {
+		llvm::StringRef chunk = data;
+		if(!readValue(chunk, chunkHeader) || chunkHeader.version != MOOCOV_MAPPED_VERSION) {
+			return !isFirstChunk;
+		}
+
+		if(chunkHeader.size < sizeof(chunkHeader) || chunkHeader.size > data.size()) break;
+
+		chunk = data.substr(sizeof(chunkHeader), chunkHeader.size - sizeof(chunkHeader));
+		data = data.drop_front(chunkHeader.size);
+		isFirstChunk = false;
+
+		// a record with a size of 0 is incomplete
+		while(chunk.size() >= sizeof(record)) {
+			std::memcpy(&record, chunk.data(), sizeof(record));
+			if(record.size < sizeof(record) + record.idLength || record.size > chunk.size()) break;
+
+			llvm::StringRef recordData = chunk.substr(sizeof(record), record.size - sizeof(record));
+			chunk = chunk.drop_front(record.size);
+
+			FileCoverage cov{FileID::parse(recordData.substr(0, record.idLength)), record.kind == MOOCOV_KIND_FLAGS};
+
+			// the data is the same as a dense payload, after the padded ID
+			std::size_t dataOffset = (sizeof(record) + record.idLength + MOOCOV_MAPPED_ALIGNMENT - 1) / MOOCOV_MAPPED_ALIGNMENT * MOOCOV_MAPPED_ALIGNMENT;
+			recordData = recordData.drop_front(std::min(dataOffset - sizeof(record), recordData.size()));
+
+			entry.kind = record.kind;
+			entry.encoding = MOOCOV_DUMP_DENSE;
+			entry.numSignals = entry.numRecords = record.numSignals;
+			if(!readPayload(recordData, entry, cov)) return false;
+
+			coverage.addFileCoverage(cov);
+		}
+	}
+
+	return !isFirstChunk;
+}
+
+// Reads the next line, without the line break.
+static llvm::StringRef readLine(llvm::StringRef& data) {
+	llvm::StringRef line;
+	std::tie(line, data) = data.split('\n');
+	return line;
+}
+
+// Reads a dump in the text format, up until the empty line ending it, the end of the data, or the start of a binary dump.
+// Older runtimes didn't end the dumps, so their consecutive text dumps are read as one.
+static bool readTextDump(llvm::StringRef& data, ContextSelector selectContext) {
+	llvm::StringRef line, fileIDStr, kindStr, signalIDStr, hitCountStr;
 	signalid_t signalID;
-	unsigned hitCount;
+	std::size_t hitCount;
 
-	std::string buffer;
-	while(fs >> buffer) {
-		fileID = FileID::parse(buffer);
-		FileCoverage cov{fileID};
+	// "@<context>", if the dump belongs to one
+	llvm::StringRef context;
+	if(data.startswith("@")) context = readLine(data).drop_front();
 
-		while(fs >> buffer && buffer != ";") {
-			utils::parseFastInteger(buffer, signalID);
+	CoverageData& coverage = selectContext(context);
 
-			fs >> buffer;
-			utils::parseFastInteger(buffer, hitCount);
+	while(!data.empty() && !isBinaryDump(data)) {
+		line = readLine(data);
+		if(line.empty()) break;
+
+		// "<file ID>", or "<file ID> f" if the file only has hit flags
+		std::tie(fileIDStr, kindStr) = line.split(' ');
+		FileCoverage cov{FileID::parse(fileIDStr), kindStr == "f"};
+
+		// "<signal ID> <hit count>", or just "<signal ID>" for hit flags
+		while(!data.empty() && (line = readLine(data)) != ";") {
+			std::tie(signalIDStr, hitCountStr) = line.split(' ');
+			if(!utils::tryParseFastInteger(signalIDStr, signalID)) return false;
+
+			if(cov.isHitOnly()) {
+				hitCount = 1;
+			} else if(!utils::tryParseFastInteger(hitCountStr, hitCount)) {
+				return false;
+			}
 
 			cov.setHitCount(signalID, hitCount);
 		}
 
-		addFileCoverage(cov);
+		coverage.addFileCoverage(cov);
+	}
+
+	return true;
+}
+
+constexpr std::size_t CoverageData::allDumps;
+
+bool CoverageData::read(const std::string& filePath, std::size_t numDumps) {
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(filePath);
+	if(!buffer) return false;
+
+	return readBuffer((*buffer)->getBuffer(), numDumps);
+}
+
+// Reads the first numDumps dumps of a data file (or a counter file of MOOCOV_MAPPED_COUNTERS mode, which has no context).
+static bool readDumps(llvm::StringRef data, std::size_t numDumps, ContextSelector selectContext) {
+	if(numDumps == 0) return true;
+
+	if(data.startswith(llvm::StringRef{MOOCOV_MAPPED_MAGIC, MOOCOV_MAPPED_MAGIC_LENGTH})) {
+		return readMappedCounters(data, selectContext(""));
+	}
+
+	// every dump appends to the data file, possibly in a different format than the previous one
+	for(std::size_t i = 0; i < numDumps && !data.empty(); ++i) {
+		bool ok = isBinaryDump(data)
+			? readBinaryDump(data, selectContext)
+			: readTextDump(data, selectContext);
+
+		if(!ok) return false;
 	}
 
-	fs.close();
 	return true;
 }
 
+bool CoverageData::readBuffer(llvm::StringRef data, std::size_t numDumps) {
+	return readDumps(data, numDumps, [this](llvm::StringRef) -> CoverageData& { return *this; });
+}
+
+bool CoverageData::readContexts(const std::string& filePath, std::map<std::string, CoverageData>& contexts) {
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(filePath);
+	if(!buffer) return false;
+
+	return readDumps((*buffer)->getBuffer(), allDumps, [&contexts](llvm::StringRef context) -> CoverageData& { return contexts[context.str()]; });
+}
+
 } // end namespace libmoocov
@@ -43,6 +43,57 @@ bool SignalMap::read(const std::string& filePath) {
 
 			add(signal);
 		}
+
+		// the granularity of the signals, if it's coarser than the default
+		granularity = Granularity::Expression;
+		if((fs >> std::ws).peek() == '%') {
+			fs >> buffer;
+
+			if(buffer == "%function") granularity = Granularity::Function;
+			else if(buffer == "%block") granularity = Granularity::Block;
+		}
+
+		// the derived signals, if any, each followed by the terms of its hit count: "+<signal ID>" or "-<signal ID>"
+		if((fs >> std::ws).peek() == '=') {
+			fs.get();
+
+			fs >> buffer;
+			utils::parseFastInteger(buffer, numSignals);
+
+			for(unsigned i = 0; i < numSignals; ++i) {
+				signal.fileID = fileID;
+
+				fs >> buffer;
+				utils::parseFastInteger(buffer, signal.id);
+
+				fs >> buffer;
+				utils::parseFastInteger(buffer, signal.sourceRange.begin.line);
+
+				fs >> buffer;
+				utils::parseFastInteger(buffer, signal.sourceRange.begin.column);
+
+				fs >> buffer;
+				utils::parseFastInteger(buffer, signal.sourceRange.end.line);
+
+				fs >> buffer;
+				utils::parseFastInteger(buffer, signal.sourceRange.end.column);
+
+				add(signal);
+
+				unsigned numTerms;
+				fs >> buffer;
+				utils::parseFastInteger(buffer, numTerms);
+
+				CounterExpression& count = derivedSignals[signal.id];
+				for(unsigned j = 0; j < numTerms; ++j) {
+					fs >> buffer;
+
+					signalid_t id;
+					utils::parseFastInteger(llvm::StringRef{buffer}.drop_front(), id);
+					count.push_back(std::make_pair(id, buffer[0] == '-' ? -1L : 1L));
+				}
+			}
+		}
 	}
 
 	fs.close();
@@ -0,0 +1,121 @@
+#ifndef MOOCOV_DUMPFORMAT_H
+#define MOOCOV_DUMPFORMAT_H
+
+// Describes the binary formats of the data files written by moocov_dump(), and of the counter files of MOOCOV_MAPPED_COUNTERS mode.
+// Shared between the runtime, which writes them, and libmoocov, which reads them.
+//
+// Each dump appends a block to the data file, which consists of:
+//  - a moocov_dump_header_t,
+//  - in version 2, the name of the context the dump belongs to (see moocov_set_context()): its length as a uint32_t, followed by the name without a null terminator,
+//  - a moocov_dump_file_t for each file (the file table),
+//  - the IDs of the files, without null terminators (the ID table),
+//  - the payload of each file, in the order of the file table.
+// All integers are written in the byte order of the instrumented program, and nothing is aligned.
+// A reader with a different byte order won't recognize the version, so it won't misinterpret the data.
+
+#include <stdint.h>
+
+// The kinds of data that can be gathered about the signals of a file.
+// 32-bit hit counters (moocov_data_t).
+#define MOOCOV_KIND_COUNTS 0
+// Whether the signal was hit at all (moocov_flag_t).
+#define MOOCOV_KIND_FLAGS 1
+// Hit counters of other widths (moocov_data8_t, moocov_data16_t and moocov_data64_t).
+#define MOOCOV_KIND_COUNTS8 2
+#define MOOCOV_KIND_COUNTS16 3
+#define MOOCOV_KIND_COUNTS64 4
+
+// Set in the kind of hit counters that stop at their maximum value instead of wrapping around.
+#define MOOCOV_KIND_SATURATING 0x80
+
+// Gets the size of a counter or flag of a kind, in bytes.
+#define MOOCOV_KIND_ELEMENT_SIZE(KIND) \
+	(((KIND) & ~MOOCOV_KIND_SATURATING) == MOOCOV_KIND_FLAGS ? 1 : \
+	((KIND) & ~MOOCOV_KIND_SATURATING) == MOOCOV_KIND_COUNTS8 ? 1 : \
+	((KIND) & ~MOOCOV_KIND_SATURATING) == MOOCOV_KIND_COUNTS16 ? 2 : \
+	((KIND) & ~MOOCOV_KIND_SATURATING) == MOOCOV_KIND_COUNTS64 ? 8 : 4)
+
+// Starts every binary dump. Can never start a text dump, as file IDs are printable.
+#define MOOCOV_DUMP_MAGIC "\x7FMCD"
+#define MOOCOV_DUMP_MAGIC_LENGTH 4
+
+// Dumps that belong to a context are written as version 2. Others are written as version 1, which is the same without the name of the context.
+#define MOOCOV_DUMP_VERSION 2
+#define MOOCOV_DUMP_VERSION_WITHOUT_CONTEXT 1
+
+// The encodings of the payloads.
+// A uint32_t signal index and hit count pair for each non-zero counter, or a uint32_t signal index for each set flag.
+// The hit count is as wide as the counters of the file's kind (see MOOCOV_KIND_ELEMENT_SIZE()).
+#define MOOCOV_DUMP_SPARSE 0
+// The data array of the file, as is: an unsigned integer of the width of the kind for each counter, or a uint8_t for each flag.
+#define MOOCOV_DUMP_DENSE 1
+// Runs of consecutive hit signals. Each run consists of:
+//  - the number of unhit signals between the end of the previous run (or the start of the file) and this one,
+//  - the number of signals in the run,
+//  - the hit count of each signal in the run, unless the file has flags.
+// All of them are varints: unsigned integers written 7 bits at a time, least significant first, with the high bit of each byte set if more follow (LEB128).
+// numRecords is the number of runs.
+#define MOOCOV_DUMP_RUNS 2
+
+// Gets the maximum size of a varint holding an integer of the given size, in bytes.
+#define MOOCOV_VARINT_MAX_SIZE(SIZE) (((SIZE) * 8 + 6) / 7)
+
+typedef struct {
+	char magic[MOOCOV_DUMP_MAGIC_LENGTH];
+	uint32_t version;
+
+	uint32_t numFiles;
+	uint32_t idTableSize;
+} moocov_dump_header_t;
+
+typedef struct {
+	// the location of the ID of the file in the ID table
+	uint32_t idOffset;
+	uint32_t idLength;
+
+	uint8_t kind;
+	uint8_t encoding;
+	uint16_t reserved;
+
+	uint32_t numSignals;
+
+	// the number of sparse records or runs, or the same as numSignals for dense payloads
+	uint32_t numRecords;
+} moocov_dump_file_t;
+
+// The counter files of MOOCOV_MAPPED_COUNTERS mode are written by the kernel from the memory of the program, rather than by moocov_dump().
+// They consist of chunks, each starting with a moocov_mapped_chunk_t, and filled with a record for each file:
+//  - a moocov_mapped_file_t,
+//  - the ID of the file, padded to MOOCOV_MAPPED_ALIGNMENT bytes,
+//  - the data array of the file (as in a MOOCOV_DUMP_DENSE payload), padded to MOOCOV_MAPPED_ALIGNMENT bytes.
+// The size of a record is only set once it is complete, so a record with a size of 0 ends its chunk.
+// The program may have crashed while adding a chunk, in which case the chunk has no valid header; this ends the counter file.
+
+// Starts every chunk of a counter file.
+#define MOOCOV_MAPPED_MAGIC "\x7FMCM"
+#define MOOCOV_MAPPED_MAGIC_LENGTH 4
+
+#define MOOCOV_MAPPED_VERSION 1
+
+#define MOOCOV_MAPPED_ALIGNMENT 8
+
+typedef struct {
+	char magic[MOOCOV_MAPPED_MAGIC_LENGTH];
+	uint32_t version;
+
+	// the size of the chunk in bytes, including this header
+	uint64_t size;
+} moocov_mapped_chunk_t;
+
+typedef struct {
+	// the size of the record in bytes, including this header and the padding
+	uint32_t size;
+	uint32_t idLength;
+
+	uint8_t kind;
+	uint8_t reserved[3];
+
+	uint32_t numSignals;
+} moocov_mapped_file_t;
+
+#endif // MOOCOV_DUMPFORMAT_H
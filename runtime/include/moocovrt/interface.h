@@ -16,4 +16,9 @@ MOOCOV_EXTERN_C void moocov_disable();
 MOOCOV_EXTERN_C void moocov_reset();
 MOOCOV_EXTERN_C void moocov_dump();
 
+// Labels the hits from now on with a context, e.g. the name of the test case about to run, or with none if the name is null.
+// The hits so far are dumped under the previous context first (unless there are none), so each dump belongs to a single context.
+// Returns 0 if that dump failed, in which case the previous context stays active.
+MOOCOV_EXTERN_C int moocov_set_context(const char* name);
+
 #endif // MOOCOV_RUNTIME_INTERFACE_H
@@ -5,43 +5,393 @@
 // For the public interface, see interface.h.
 
 #include "moocovrt/interface.h"
+#include "moocovrt/likely.h"
+#include "moocovrt/dumpformat.h"
+
+// Whether moocov_enable() and moocov_disable() does anything.
+// While disabled, the instrumented code registers its hits in a scratch buffer instead of the real data, so the instrumented code has to go through the pointer in the moocov_file_t, like in MOOCOV_MAPPED_COUNTERS mode.
+// In MOOCOV_SHARDED_COUNTERS mode, the same goes for the shards: the instrumented code caches the pointer to the data of each shard, rather than the data itself.
+// The instrumented sources have to be compiled with the same value as the runtime (see moocov-instrument --allow-disable).
+#ifndef ALLOW_DISABLE
+#	define ALLOW_DISABLE 0
+#endif
+
+// Whether the counters are updated with (relaxed) atomic increments, making them safe to use from multiple threads.
+// Otherwise concurrent hits on the same signal may get lost. Like ALLOW_DISABLE, this has to match between the runtime and the instrumented sources.
+#ifndef MOOCOV_ATOMIC_COUNTERS
+#	define MOOCOV_ATOMIC_COUNTERS 0
+#endif
+
+// Whether each thread gets its own copy (shard) of the counters of each file, which are summed up when dumping.
+// This makes hits from multiple threads contention-free, at the cost of memory and a thread-local load per hit.
+// The runtime has to be linked with pthreads in this mode.
+#ifndef MOOCOV_SHARDED_COUNTERS
+#	define MOOCOV_SHARDED_COUNTERS 0
+#endif
+
+// Whether the data of each file is moved into a memory-mapped counter file when the runtime is loaded.
+// The kernel then writes the data to disk even if the program crashes or gets killed, without moocov_dump() having to be called.
+// The instrumented code has to go through the pointer in the moocov_file_t instead of the static data array, which costs an extra load per hit.
+#ifndef MOOCOV_MAPPED_COUNTERS
+#	define MOOCOV_MAPPED_COUNTERS 0
+#endif
+
+// Whether each file has two data buffers: the active one, which the hits are registered in, and a spare one.
+// Dumping swaps them, and writes out the retired buffer, which the other threads don't write to anymore (save for the hits that were already underway).
+// This is what the background dumps (see MOOCOV_DUMP_INTERVAL in runtime.c) are meant to be used with. It requires MOOCOV_ATOMIC_COUNTERS, as hits can still land in a retired buffer while it's being written out.
+// Like in MOOCOV_MAPPED_COUNTERS mode, the instrumented code has to go through the pointer in the moocov_file_t.
+#ifndef MOOCOV_BUFFERED_COUNTERS
+#	define MOOCOV_BUFFERED_COUNTERS 0
+#endif
+
+#if MOOCOV_ATOMIC_COUNTERS && MOOCOV_SHARDED_COUNTERS
+#	error "MOOCOV_ATOMIC_COUNTERS and MOOCOV_SHARDED_COUNTERS are mutually exclusive"
+#endif
+
+#if MOOCOV_SHARDED_COUNTERS && MOOCOV_MAPPED_COUNTERS
+#	error "MOOCOV_SHARDED_COUNTERS and MOOCOV_MAPPED_COUNTERS are mutually exclusive"
+#endif
+
+#if MOOCOV_BUFFERED_COUNTERS && (!MOOCOV_ATOMIC_COUNTERS || MOOCOV_MAPPED_COUNTERS)
+#	error "MOOCOV_BUFFERED_COUNTERS requires MOOCOV_ATOMIC_COUNTERS, and is mutually exclusive with MOOCOV_MAPPED_COUNTERS"
+#endif
+
+// Whether moocov_disable() points the data of the files to the scratch buffer.
+#define MOOCOV_REDIRECTED_DATA ALLOW_DISABLE
+
+// Whether moocov_disable() points the data of the shards to the scratch buffer too.
+#define MOOCOV_REDIRECTED_SHARDS (ALLOW_DISABLE && MOOCOV_SHARDED_COUNTERS)
+
+// Whether the instrumented code has to look up the data of a file through its moocov_file_t, as the runtime may move it.
+#define MOOCOV_INDIRECT_DATA (MOOCOV_MAPPED_COUNTERS || MOOCOV_BUFFERED_COUNTERS || MOOCOV_REDIRECTED_DATA)
 
 typedef char* moocov_fileid_t;
 typedef unsigned int moocov_data_t;
+typedef unsigned char moocov_flag_t;
+
+// The counters of the other widths (see MOOCOV_KIND_COUNTS8 and the like).
+typedef uint8_t moocov_data8_t;
+typedef uint16_t moocov_data16_t;
+typedef uint64_t moocov_data64_t;
 typedef unsigned long long moocov_data_size_t;
 
 typedef struct _moocov_file_t {
 	moocov_fileid_t id;
+	uint32_t idLength; // the length of the ID, so that dumps don't have to measure it; set by the runtime if 0
+	unsigned char kind; // MOOCOV_KIND_*
 
-	int linked;
-	moocov_data_t* data;
+	int linked; // always set for the files in the MOOCOV_FILES_SECTION
+	void* data;
 	moocov_data_size_t dataLength;
 
 	struct _moocov_file_t* next;
+
+	// The values of the data at the previous dump, followed by the changes since then, if the runtime is built with INCREMENTAL_DUMPS. Set by the runtime.
+	void* shadow;
+
+#if MOOCOV_SHARDED_COUNTERS
+	// The per-thread copies of the counters, guarded by the runtime.
+	struct _moocov_shard_t* shards;
+#endif
+
+#if MOOCOV_MAPPED_COUNTERS
+	// Whether the data has been moved into the counter file.
+	int mapped;
+#endif
+
+#if MOOCOV_BUFFERED_COUNTERS
+	// The data buffer that isn't in use, allocated by the runtime when it is loaded.
+	void* spare;
+#endif
+
+#if MOOCOV_REDIRECTED_DATA
+	// The data the hits are registered in while data gathering is enabled. Set by the runtime when it is loaded.
+	void* active;
+#endif
 } moocov_file_t;
 
+// The suffixes of the symbols that depend on the mode (see MOOCOV_MODE_SYMBOL()): one for each of the above that is set.
+#if MOOCOV_ATOMIC_COUNTERS
+#	define MOOCOV_MODE_SUFFIX_ATOMIC _atomic
+#else
+#	define MOOCOV_MODE_SUFFIX_ATOMIC
+#endif
+
+#if MOOCOV_SHARDED_COUNTERS
+#	define MOOCOV_MODE_SUFFIX_SHARDED _sharded
+#else
+#	define MOOCOV_MODE_SUFFIX_SHARDED
+#endif
+
+#if MOOCOV_MAPPED_COUNTERS
+#	define MOOCOV_MODE_SUFFIX_MAPPED _mapped
+#else
+#	define MOOCOV_MODE_SUFFIX_MAPPED
+#endif
+
+#if MOOCOV_BUFFERED_COUNTERS
+#	define MOOCOV_MODE_SUFFIX_BUFFERED _buffered
+#else
+#	define MOOCOV_MODE_SUFFIX_BUFFERED
+#endif
+
+#if ALLOW_DISABLE
+#	define MOOCOV_MODE_SUFFIX_DISABLE _disable
+#else
+#	define MOOCOV_MODE_SUFFIX_DISABLE
+#endif
+
+#define MOOCOV_PASTE_MODE(NAME, ATOMIC, SHARDED, MAPPED, BUFFERED, DISABLE) NAME##ATOMIC##SHARDED##MAPPED##BUFFERED##DISABLE
+#define MOOCOV_EXPAND_MODE(NAME, ATOMIC, SHARDED, MAPPED, BUFFERED, DISABLE) MOOCOV_PASTE_MODE(NAME, ATOMIC, SHARDED, MAPPED, BUFFERED, DISABLE)
+
+// Gets the name of a symbol of the runtime that only exists in the current mode, e.g. NAME_sharded_disable.
+#define MOOCOV_MODE_SYMBOL(NAME) \
+	MOOCOV_EXPAND_MODE(NAME, MOOCOV_MODE_SUFFIX_ATOMIC, MOOCOV_MODE_SUFFIX_SHARDED, MOOCOV_MODE_SUFFIX_MAPPED, MOOCOV_MODE_SUFFIX_BUFFERED, MOOCOV_MODE_SUFFIX_DISABLE)
+
+// Defined by the runtime, and referenced by every file defined with MOOCOV_DEFINE_FILE_EX().
+// The files are found through the sections, so outside of MOOCOV_SHARDED_COUNTERS the instrumented code may not call the runtime at all. Without this reference, the linker wouldn't pull the runtime out of a static library, and its constructor (setting up e.g. the mapped counter file) would never run.
+// Its name depends on the mode, as the modes change the layout of moocov_file_t, which the runtime walks the sections with: linking files with a runtime built for another mode fails with an undefined reference to it, rather than corrupting the data.
+// It's hidden, so that an executable or shared library containing instrumented files fails to link without its own copy of the runtime, which registers its sections.
+#define MOOCOV_RUNTIME_ANCHOR MOOCOV_MODE_SYMBOL(_moocov_runtime_anchor)
+
+MOOCOV_EXTERN_C const char MOOCOV_RUNTIME_ANCHOR __attribute__((visibility("hidden")));
+
 MOOCOV_EXTERN_C void _moocov_link(moocov_file_t* file);
 MOOCOV_EXTERN_C void _moocov_signal(moocov_file_t* file, moocov_data_size_t index);
 
+#if MOOCOV_REDIRECTED_SHARDS
+
+// Gets where the calling thread's copy of the counters of the specified file is, allocating it on first use.
+// The runtime points it to the scratch buffer while data gathering is disabled, so it has to be loaded for every hit.
+MOOCOV_EXTERN_C void** _moocov_get_shard_slot(moocov_file_t* file);
+
+#elif MOOCOV_SHARDED_COUNTERS
+
+// Gets the calling thread's copy of the counters of the specified file, allocating it on first use.
+MOOCOV_EXTERN_C void* _moocov_get_shard(moocov_file_t* file);
+
+#endif
+
+// Initializers of the moocov_file_t fields specific to the current mode.
+#if MOOCOV_SHARDED_COUNTERS || MOOCOV_MAPPED_COUNTERS || MOOCOV_BUFFERED_COUNTERS
+#	define MOOCOV_FILE_COUNTERS_INIT , 0
+#else
+#	define MOOCOV_FILE_COUNTERS_INIT
+#endif
+
+#if MOOCOV_REDIRECTED_DATA
+#	define MOOCOV_FILE_MODE_INIT MOOCOV_FILE_COUNTERS_INIT , 0
+#else
+#	define MOOCOV_FILE_MODE_INIT MOOCOV_FILE_COUNTERS_INIT
+#endif
+
+// We use the GCC atomic builtins instead of C11 _Atomic, as the same counters are also accessed from C++ code.
+// On x86, this compiles to a single lock-prefixed add.
+// The _N variants register N hits at once, for loops whose iterations are counted in a local variable (see moocov-instrument --local-loop-counters).
+#if MOOCOV_ATOMIC_COUNTERS
+#	define MOOCOV_HIT(COUNTER) ((void)__atomic_fetch_add(&(COUNTER), 1, __ATOMIC_RELAXED))
+#	define MOOCOV_HIT_N(COUNTER, N) ((void)__atomic_fetch_add(&(COUNTER), (N), __ATOMIC_RELAXED))
+#	define MOOCOV_SET_FLAG(FLAG) ((void)__atomic_store_n(&(FLAG), 1, __ATOMIC_RELAXED))
+#	define MOOCOV_SET_FLAG_N(FLAG, N) ((void)((N) && (__atomic_store_n(&(FLAG), 1, __ATOMIC_RELAXED), 1)))
+#else
+#	define MOOCOV_HIT(COUNTER) ((void)++(COUNTER))
+#	define MOOCOV_HIT_N(COUNTER, N) ((void)((COUNTER) += (N)))
+#	define MOOCOV_SET_FLAG(FLAG) ((void)((FLAG) = 1))
+#	define MOOCOV_SET_FLAG_N(FLAG, N) ((void)((N) && ((FLAG) = 1)))
+#endif
+
+// Defines an inline function registering a hit on a counter of the given type that stops at its maximum value instead of wrapping around.
+// Without MOOCOV_ATOMIC_COUNTERS, this is a compare and an add, without branching.
+// The _n variant adds N hits, but no more than what's left until the maximum.
+#if MOOCOV_ATOMIC_COUNTERS
+#	define MOOCOV_DEFINE_SATURATING_HIT(TYPE) \
+	static inline void _moocov_hit_saturating_##TYPE(TYPE* counter) { \
+		TYPE value = __atomic_load_n(counter, __ATOMIC_RELAXED); \
+		while(value != (TYPE)~(TYPE)0 && !__atomic_compare_exchange_n(counter, &value, (TYPE)(value + 1), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)); \
+	} \
+	static inline void _moocov_hit_saturating_n_##TYPE(TYPE* counter, moocov_data_size_t n) { \
+		TYPE value = __atomic_load_n(counter, __ATOMIC_RELAXED), sum; \
+		do { \
+			moocov_data_size_t room = (TYPE)~(TYPE)0 - value; \
+			sum = (TYPE)(value + (n < room ? n : room)); \
+		} while(sum != value && !__atomic_compare_exchange_n(counter, &value, sum, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)); \
+	}
+#else
+#	define MOOCOV_DEFINE_SATURATING_HIT(TYPE) \
+	static inline void _moocov_hit_saturating_##TYPE(TYPE* counter) { \
+		*counter += (TYPE)(*counter != (TYPE)~(TYPE)0); \
+	} \
+	static inline void _moocov_hit_saturating_n_##TYPE(TYPE* counter, moocov_data_size_t n) { \
+		moocov_data_size_t room = (TYPE)~(TYPE)0 - *counter; \
+		*counter += (TYPE)(n < room ? n : room); \
+	}
+#endif
+
+MOOCOV_DEFINE_SATURATING_HIT(moocov_data8_t)
+MOOCOV_DEFINE_SATURATING_HIT(moocov_data16_t)
+MOOCOV_DEFINE_SATURATING_HIT(moocov_data_t)
+MOOCOV_DEFINE_SATURATING_HIT(moocov_data64_t)
+
+#define MOOCOV_HIT_SATURATING(TYPE, COUNTER) _moocov_hit_saturating_##TYPE(&(COUNTER))
+#define MOOCOV_HIT_SATURATING_N(TYPE, COUNTER, N) _moocov_hit_saturating_n_##TYPE(&(COUNTER), N)
+
 #define MOOCOV_FILE(ID) _moocov_file##ID
 #define MOOCOV_FILEREF(ID) &MOOCOV_FILE(ID)
 
-#define MOOCOV_DEFINE_FILE(ID, NUMSIGNALS) \
-	static moocov_data_t _moocov_data##ID[NUMSIGNALS]; \
+// Defines an inline function returning the data that the calling thread should register its hits in.
+#if MOOCOV_INDIRECT_DATA
+#	define MOOCOV_DEFINE_DIRECT_ACCESSOR(ID, TYPE) \
+	static inline TYPE* _moocov_counters##ID(void) { \
+		return (TYPE*)__atomic_load_n(&MOOCOV_FILE(ID).data, __ATOMIC_RELAXED); \
+	}
+#else
+#	define MOOCOV_DEFINE_DIRECT_ACCESSOR(ID, TYPE) \
+	static inline TYPE* _moocov_counters##ID(void) { \
+		return _moocov_data##ID; \
+	}
+#endif
+
+#if MOOCOV_REDIRECTED_SHARDS
+#	define MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, TYPE) \
+	static __thread void** _moocov_shard##ID; \
+	static inline TYPE* _moocov_counters##ID(void) { \
+		void** slot = _moocov_shard##ID; \
+		if(MOOCOV_UNLIKELY(!slot)) { \
+			slot = _moocov_shard##ID = _moocov_get_shard_slot(MOOCOV_FILEREF(ID)); \
+		} \
+		return (TYPE*)__atomic_load_n(slot, __ATOMIC_RELAXED); \
+	}
+#elif MOOCOV_SHARDED_COUNTERS
+#	define MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, TYPE) \
+	static __thread TYPE* _moocov_shard##ID; \
+	static inline TYPE* _moocov_counters##ID(void) { \
+		TYPE* shard = _moocov_shard##ID; \
+		if(MOOCOV_UNLIKELY(!shard)) { \
+			shard = _moocov_shard##ID = (TYPE*)_moocov_get_shard(MOOCOV_FILEREF(ID)); \
+		} \
+		return shard; \
+	}
+#else
+#	define MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, TYPE) MOOCOV_DEFINE_DIRECT_ACCESSOR(ID, TYPE)
+#endif
+
+// The sections that MOOCOV_DEFINE_FILE_EX() places the descriptors and data arrays of the files in.
+// The linker gathers them from all instrumented files of the program, and defines __start_<section> and __stop_<section> symbols around them, which the runtime finds the files through.
+// The names have to be valid C identifiers for the symbols to be defined.
+#define MOOCOV_FILES_SECTION "moocov_files"
+#define MOOCOV_COUNTS_SECTION "moocov_cnts"
+#define MOOCOV_FLAGS_SECTION "moocov_flags"
+
+// The properties of the data kinds, as used by MOOCOV_DEFINE_FILE_EX().
+// The counters of all widths share a section, as they are only ever cleared together.
+#define MOOCOV_COUNTS_TYPE moocov_data_t
+#define MOOCOV_COUNTS_KIND MOOCOV_KIND_COUNTS
+#define MOOCOV_COUNTS_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS_HIT(COUNTER) MOOCOV_HIT(COUNTER)
+#define MOOCOV_COUNTS_HIT_N(COUNTER, N) MOOCOV_HIT_N(COUNTER, N)
+#define MOOCOV_COUNTS_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data_t)
+
+#define MOOCOV_COUNTS8_TYPE moocov_data8_t
+#define MOOCOV_COUNTS8_KIND MOOCOV_KIND_COUNTS8
+#define MOOCOV_COUNTS8_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS8_HIT(COUNTER) MOOCOV_HIT(COUNTER)
+#define MOOCOV_COUNTS8_HIT_N(COUNTER, N) MOOCOV_HIT_N(COUNTER, N)
+#define MOOCOV_COUNTS8_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data8_t)
+
+#define MOOCOV_COUNTS16_TYPE moocov_data16_t
+#define MOOCOV_COUNTS16_KIND MOOCOV_KIND_COUNTS16
+#define MOOCOV_COUNTS16_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS16_HIT(COUNTER) MOOCOV_HIT(COUNTER)
+#define MOOCOV_COUNTS16_HIT_N(COUNTER, N) MOOCOV_HIT_N(COUNTER, N)
+#define MOOCOV_COUNTS16_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data16_t)
+
+#define MOOCOV_COUNTS64_TYPE moocov_data64_t
+#define MOOCOV_COUNTS64_KIND MOOCOV_KIND_COUNTS64
+#define MOOCOV_COUNTS64_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS64_HIT(COUNTER) MOOCOV_HIT(COUNTER)
+#define MOOCOV_COUNTS64_HIT_N(COUNTER, N) MOOCOV_HIT_N(COUNTER, N)
+#define MOOCOV_COUNTS64_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data64_t)
+
+// The saturating variants of the counters of each width.
+#define MOOCOV_COUNTS_SAT_TYPE moocov_data_t
+#define MOOCOV_COUNTS_SAT_KIND (MOOCOV_KIND_COUNTS | MOOCOV_KIND_SATURATING)
+#define MOOCOV_COUNTS_SAT_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS_SAT_HIT(COUNTER) MOOCOV_HIT_SATURATING(moocov_data_t, COUNTER)
+#define MOOCOV_COUNTS_SAT_HIT_N(COUNTER, N) MOOCOV_HIT_SATURATING_N(moocov_data_t, COUNTER, N)
+#define MOOCOV_COUNTS_SAT_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data_t)
+
+#define MOOCOV_COUNTS8_SAT_TYPE moocov_data8_t
+#define MOOCOV_COUNTS8_SAT_KIND (MOOCOV_KIND_COUNTS8 | MOOCOV_KIND_SATURATING)
+#define MOOCOV_COUNTS8_SAT_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS8_SAT_HIT(COUNTER) MOOCOV_HIT_SATURATING(moocov_data8_t, COUNTER)
+#define MOOCOV_COUNTS8_SAT_HIT_N(COUNTER, N) MOOCOV_HIT_SATURATING_N(moocov_data8_t, COUNTER, N)
+#define MOOCOV_COUNTS8_SAT_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data8_t)
+
+#define MOOCOV_COUNTS16_SAT_TYPE moocov_data16_t
+#define MOOCOV_COUNTS16_SAT_KIND (MOOCOV_KIND_COUNTS16 | MOOCOV_KIND_SATURATING)
+#define MOOCOV_COUNTS16_SAT_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS16_SAT_HIT(COUNTER) MOOCOV_HIT_SATURATING(moocov_data16_t, COUNTER)
+#define MOOCOV_COUNTS16_SAT_HIT_N(COUNTER, N) MOOCOV_HIT_SATURATING_N(moocov_data16_t, COUNTER, N)
+#define MOOCOV_COUNTS16_SAT_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data16_t)
+
+#define MOOCOV_COUNTS64_SAT_TYPE moocov_data64_t
+#define MOOCOV_COUNTS64_SAT_KIND (MOOCOV_KIND_COUNTS64 | MOOCOV_KIND_SATURATING)
+#define MOOCOV_COUNTS64_SAT_SECTION_NAME MOOCOV_COUNTS_SECTION
+#define MOOCOV_COUNTS64_SAT_HIT(COUNTER) MOOCOV_HIT_SATURATING(moocov_data64_t, COUNTER)
+#define MOOCOV_COUNTS64_SAT_HIT_N(COUNTER, N) MOOCOV_HIT_SATURATING_N(moocov_data64_t, COUNTER, N)
+#define MOOCOV_COUNTS64_SAT_ACCESSOR(ID) MOOCOV_DEFINE_COUNTERS_ACCESSOR(ID, moocov_data64_t)
+
+// Setting a flag is idempotent, so it's safe to do from multiple threads without sharding.
+#define MOOCOV_FLAGS_TYPE moocov_flag_t
+#define MOOCOV_FLAGS_KIND MOOCOV_KIND_FLAGS
+#define MOOCOV_FLAGS_SECTION_NAME MOOCOV_FLAGS_SECTION
+#define MOOCOV_FLAGS_HIT(FLAG) MOOCOV_SET_FLAG(FLAG)
+#define MOOCOV_FLAGS_HIT_N(FLAG, N) MOOCOV_SET_FLAG_N(FLAG, N)
+#define MOOCOV_FLAGS_ACCESSOR(ID) MOOCOV_DEFINE_DIRECT_ACCESSOR(ID, moocov_flag_t)
+
+// Defines the data of an instrumented file, along with an inline function registering a hit on one of its signals.
+// KIND is COUNTS (32-bit counters), COUNTS8, COUNTS16 or COUNTS64, any of these with a _SAT suffix for saturating counters, or FLAGS.
+// By default, the hit is registered directly in the file's static data array, so the compiler can fold it into a single memory operation.
+// The file doesn't have to be registered with the runtime, as the runtime finds it in its section. The descriptors form an array there, so their alignment is fixed to keep the compiler from padding them.
+// As the section bounds are resolved within each executable or shared library, each of them that contains instrumented files has to be linked with the runtime.
+#define MOOCOV_DEFINE_FILE_EX(ID, NUMSIGNALS, KIND) \
+	__attribute__((section(MOOCOV_##KIND##_SECTION_NAME), used)) \
+	static MOOCOV_##KIND##_TYPE _moocov_data##ID[NUMSIGNALS]; \
+	__attribute__((section(MOOCOV_FILES_SECTION), used, aligned(sizeof(void*)))) \
 	static moocov_file_t MOOCOV_FILE(ID) = { \
 		#ID, \
-		0, \
+		sizeof(#ID) - 1, \
+		MOOCOV_##KIND##_KIND, \
+		1, \
 		_moocov_data##ID, \
 		NUMSIGNALS, \
+		0, \
 		0 \
-	};
+		MOOCOV_FILE_MODE_INIT \
+	}; \
+	__attribute__((used)) \
+	static const char* const _moocov_anchor##ID = &MOOCOV_RUNTIME_ANCHOR; \
+	MOOCOV_##KIND##_ACCESSOR(ID) \
+	static inline void _moocov_signal##ID(moocov_data_size_t index) { \
+		MOOCOV_##KIND##_HIT(_moocov_counters##ID()[index]); \
+	} \
+	static inline void _moocov_signal_n##ID(moocov_data_size_t index, moocov_data_size_t n) { \
+		MOOCOV_##KIND##_HIT_N(_moocov_counters##ID()[index], n); \
+	}
 
-// TODO: modify moocov-instrument (FileInstrumentation.cpp) to emit these macros instead of direct calls
+#define MOOCOV_DEFINE_FILE(ID, NUMSIGNALS) \
+	MOOCOV_DEFINE_FILE_EX(ID, NUMSIGNALS, COUNTS)
 
-#define MOCOOV_LINK(FILEID) \
+// Registers a file with the runtime manually, for code that defines its moocov_file_t by hand, outside of the sections.
+// Files defined with MOOCOV_DEFINE_FILE*() are always registered, so this has no effect on them.
+#define MOOCOV_LINK(FILEID) \
 	_moocov_link(MOOCOV_FILEREF(FILEID))
 
-#define MOCOOV_SIGNAL(FILEID, ID) \
-	_moocov_signal(MOOCOV_FILEREF(FILEID), ID)
+#define MOOCOV_SIGNAL(FILEID, ID) \
+	_moocov_signal##FILEID(ID)
+
+// Registers N hits of a signal at once.
+#define MOOCOV_SIGNAL_N(FILEID, ID, N) \
+	_moocov_signal_n##FILEID(ID, N)
 
 #endif // MOOCOV_RUNTIME_H
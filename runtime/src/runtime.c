@@ -1,14 +1,31 @@
-#include <string.h> // memset, strlen
-#include <stdio.h> // fopen, fwrite, fclose
+// the counter file of MOOCOV_MAPPED_COUNTERS mode and the dumps need POSIX functions, which -std=c11 hides
+#if !defined(_GNU_SOURCE) && !defined(_POSIX_C_SOURCE)
+#	define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h> // memset, memcpy, strlen
+#include <stdio.h> // snprintf
+#include <stdlib.h> // malloc, calloc, realloc, free, getenv, strtoul
+#include <errno.h> // errno
+#include <time.h> // clock_gettime, nanosleep
+#include <fcntl.h> // open
+#include <unistd.h> // write, close, getpid, ftruncate, sysconf
+#include <pthread.h> // pthread_atfork, pthread_key_create, pthread_setspecific, pthread_once, pthread_create
+#include <signal.h> // sigaction, sigemptyset, and the signal numbers DUMP_SIGNAL may be set to
+#include <sys/utsname.h> // uname
 
 #include "moocovrt/runtime.h"
 #include "moocovrt/likely.h"
 #include "moocovrt/fastint.h"
 
-// Whether moocov_enable() and moocov_disable() does anything.
-// Allowing the data gathering to be disabled has a performance penalty.
-#ifndef ALLOW_DISABLE
-#	define ALLOW_DISABLE 0
+#if defined(__AVX2__)
+#	include <immintrin.h> // _mm256_loadu_si256, _mm256_testz_si256
+#elif defined(__SSE2__)
+#	include <emmintrin.h> // _mm_loadu_si128, _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+#if MOOCOV_MAPPED_COUNTERS
+#	include <sys/mman.h> // mmap, shm_open
 #endif
 
 // If ALLOW_DISABLE is set to 1, whether to have data collection enabled initially or not.
@@ -16,19 +33,119 @@
 #	define INITIAL_ENABLED 1
 #endif
 
-// The name of the output file.
+// The name of the output file, unless the MOOCOV_DUMP_FILE environment variable is set.
+// Either may contain the placeholders %p (the process ID), %h (the host name) and %t (the time of the dump, in seconds since the epoch), or %% for a % sign.
 #ifndef DUMPFILE_NAME
 #	define DUMPFILE_NAME "coverage.mocd"
 #endif
 
+// Whether to write the data file in the human-readable text format instead of the binary one, for debugging.
+// Both can be read by libmoocov.
+#ifndef TEXT_DUMPFILE
+#	define TEXT_DUMPFILE 0
+#endif
+
+// Whether to write the payloads of the binary format as runs of hit signals with variable-length integers (MOOCOV_DUMP_RUNS), rather than as fixed-width records or arrays.
+// This makes the dumps several times smaller, at the cost of some time spent encoding them; turn it off for readers that only know the fixed-width encodings.
+#ifndef COMPACT_DUMPFILE
+#	define COMPACT_DUMPFILE 1
+#endif
+
+// Whether to skip runs of unhit signals when dumping by checking the data in blocks (of 32 bytes with AVX2, 16 bytes with SSE2, 8 bytes otherwise), rather than one signal at a time.
+#ifndef SIMD_ZERO_SKIP
+#	define SIMD_ZERO_SKIP 1
+#endif
+
+// The signal that makes the runtime dump the data (e.g. SIGUSR1), to get the coverage of a running process from the outside, or 0 for none.
+// The data is dumped in the text format from the signal handler itself, without allocating any memory, into a buffer preallocated for the largest dump the registered files can make.
+#ifndef DUMP_SIGNAL
+#	define DUMP_SIGNAL 0
+#endif
+
+// Whether moocov_dump() should keep the data, and only write what has changed since the previous dump, instead of writing all of it and clearing it.
+// The dumps are read the same way either way, but this way the counters keep growing in memory (and in the counter file of MOOCOV_MAPPED_COUNTERS mode).
+// The values at the previous dump and the changes since then are kept in a shadow copy of each file's data, which takes twice as much memory as the data itself.
+#ifndef INCREMENTAL_DUMPS
+#	define INCREMENTAL_DUMPS 0
+#endif
+
+#if INCREMENTAL_DUMPS && MOOCOV_BUFFERED_COUNTERS
+#	error "INCREMENTAL_DUMPS is mutually exclusive with MOOCOV_BUFFERED_COUNTERS, which clears the data it swaps out"
+#endif
+
+// In MOOCOV_MAPPED_COUNTERS mode, whether to keep the counter file in POSIX shared memory (see shm_open()) instead of the file system.
+// This way moocov-top can watch the counters of a running program without the kernel writing them back to the disk. The program may have to be linked with -lrt.
+#ifndef MAPFILE_SHARED_MEMORY
+#	define MAPFILE_SHARED_MEMORY 0
+#endif
+
+// In MOOCOV_MAPPED_COUNTERS mode, the name of the counter file of the process: a printf() format, which gets the process ID.
+// It ends with .mocd, so that it's picked up with the data files. The name of a shared memory object has to start with a slash instead.
+#ifndef MAPFILE_NAME_FORMAT
+#	if MAPFILE_SHARED_MEMORY
+#		define MAPFILE_NAME_FORMAT "/moocov.%d"
+#	else
+#		define MAPFILE_NAME_FORMAT "coverage.%d.mocd"
+#	endif
+#endif
+
+// In MOOCOV_MAPPED_COUNTERS mode, the minimum size of the chunks the counter file is grown with.
+#ifndef MAPFILE_CHUNK_SIZE
+#	define MAPFILE_CHUNK_SIZE (64 * 1024)
+#endif
+
 #if ALLOW_DISABLE
 
-// A value indicating whether moocov is currently gathering data.
-static int g_moocov_enabled = (INITIAL_ENABLED);
+// A value indicating whether moocov is currently gathering data. The files (and shards) are redirected to the sink when it changes.
+static int g_enabled = (INITIAL_ENABLED);
 
 #endif
 
+// The files defined with MOOCOV_DEFINE_FILE_EX(), gathered into sections by the linker.
+// The bounds are weak, so that the runtime still links into a program without any instrumented files (they are null then), and hidden, so that each executable or shared library finds its own files (see moocov_module_t).
+#define MOOCOV_DECLARE_SECTION(TYPE, NAME) \
+	extern TYPE __start_##NAME[] __attribute__((weak, visibility("hidden"))); \
+	extern TYPE __stop_##NAME[] __attribute__((weak, visibility("hidden")));
+
+MOOCOV_DECLARE_SECTION(moocov_file_t, moocov_files)
+// The counters of all widths share their section, so it's only accessed as bytes.
+MOOCOV_DECLARE_SECTION(char, moocov_cnts)
+MOOCOV_DECLARE_SECTION(moocov_flag_t, moocov_flags)
+
+// Hides where a pointer comes from from the compiler.
+// The compiler assumes that the bounds of a section point to distinct objects, so it would fold comparisons between them otherwise.
+static void* _launder(void* p) {
+	__asm__("" : "+r"(p));
+	return p;
+}
+
+#define MOOCOV_SECTION_BEGIN(NAME) ((__typeof__(&__start_##NAME[0]))_launder(__start_##NAME))
+#define MOOCOV_SECTION_END(NAME) ((__typeof__(&__stop_##NAME[0]))_launder(__stop_##NAME))
+
+// The sections of an executable or shared library.
+// Each of them links its own copy of the runtime, as the section bounds are resolved within it. The copies register their sections with the one whose functions the others' calls resolve to, which is the program's own (or the first one loaded), and only that one keeps the state of the runtime and dumps the data.
+typedef struct _moocov_module_t {
+	moocov_file_t* files;
+	moocov_file_t* filesEnd;
+	char* counts;
+	char* countsEnd;
+	moocov_flag_t* flags;
+	moocov_flag_t* flagsEnd;
+
+	struct _moocov_module_t* next;
+} moocov_module_t;
+
+// Registers the sections of an executable or shared library. Its name depends on the mode, so that the copies of the runtime only share their state if they agree on the layout of the files.
+#define MOOCOV_REGISTER_MODULE MOOCOV_MODE_SYMBOL(_moocov_register_module)
+
+void MOOCOV_REGISTER_MODULE(moocov_module_t* module);
+
+// The modules registered with this copy of the runtime, in the order they were loaded. Guarded by the index lock.
+static moocov_module_t* g_modules;
+static moocov_module_t** g_modulesTail = &g_modules;
+
 // Defines a singly linked list with a head item of the moocov_file_t structures containing data.
+// Only holds the files linked by hand with _moocov_link(), the others are found through the sections.
 typedef struct {
 	moocov_file_t* head;
 	moocov_file_t* tail;
@@ -40,90 +157,1804 @@ static moocov_file_t g_head;
 // The linked list.
 static moocov_index_t g_index = { &g_head, &g_head };
 
-void moocov_enable() {
-#if ALLOW_DISABLE
-	g_moocov_enabled = 1;
+// Gets the first file of the sections of a module or the ones registered after it, or of the linked list if they're all empty.
+static moocov_file_t* _first_file_from(const moocov_module_t* module) {
+	for(; module; module = module->next) {
+		if(module->files != module->filesEnd) return module->files;
+	}
+
+	return g_index.head->next;
+}
+
+// Gets the first of all files: the sections come first, then the linked list.
+static moocov_file_t* _first_file() {
+	return _first_file_from(g_modules);
+}
+
+// Gets the module whose section contains a file, or null for the files in the linked list.
+static const moocov_module_t* _find_module(const moocov_file_t* file) {
+	const moocov_module_t* module;
+	for(module = g_modules; module; module = module->next) {
+		if(file >= module->files && file < module->filesEnd) return module;
+	}
+
+	return 0;
+}
+
+static int _is_section_file(const moocov_file_t* file) {
+	return _find_module(file) != 0;
+}
+
+static moocov_file_t* _next_file(moocov_file_t* file) {
+	const moocov_module_t* module = _find_module(file);
+	if(module) {
+		return file + 1 < module->filesEnd ? file + 1 : _first_file_from(module->next);
+	}
+
+	return file->next;
+}
+
+#if DUMP_SIGNAL
+static void _signal_dump();
+
+// Set when DUMP_SIGNAL arrives while the index lock is held. The dump is then made when the lock is released.
+static int g_signalDumpPending;
 #endif
+
+#if MOOCOV_ATOMIC_COUNTERS || MOOCOV_SHARDED_COUNTERS || DUMP_SIGNAL
+
+// Guards the linked list (and the shards of the files) when the instrumented program may be multi-threaded, or dump from a signal handler.
+// Only taken when linking a file for the first time, and when dumping or resetting, so a simple spinlock suffices.
+static char g_indexLock;
+
+static void _lock_index() {
+	while(__atomic_test_and_set(&g_indexLock, __ATOMIC_ACQUIRE));
 }
 
-void moocov_disable() {
-#if ALLOW_DISABLE
-	g_moocov_enabled = 0;
+#if DUMP_SIGNAL
+// Takes the index lock if it's free. Used by the signal handler, which would never get the lock if it interrupted the thread holding it.
+static int _try_lock_index() {
+	return !__atomic_test_and_set(&g_indexLock, __ATOMIC_ACQUIRE);
+}
+#endif
+
+static void _unlock_index() {
+	__atomic_clear(&g_indexLock, __ATOMIC_RELEASE);
+
+#if DUMP_SIGNAL
+	if(MOOCOV_UNLIKELY(__atomic_load_n(&g_signalDumpPending, __ATOMIC_RELAXED))) _signal_dump();
+#endif
+}
+
+#else
+
+static void _lock_index() {}
+static void _unlock_index() {}
+
 #endif
+
+// Gets the size of the counters or flags of a file, in bytes.
+static moocov_data_size_t _get_element_size(const moocov_file_t* file) {
+	return MOOCOV_KIND_ELEMENT_SIZE(file->kind);
+}
+
+// Gets the size of the data of a file, in bytes.
+static moocov_data_size_t _get_data_size(const moocov_file_t* file) {
+	return file->dataLength * _get_element_size(file);
+}
+
+#if MOOCOV_REDIRECTED_DATA
+
+// Where the hits of all files go while data gathering is disabled. It's never freed, as hits that were already underway may still land in it.
+static void* g_sink;
+static moocov_data_size_t g_sinkSize;
+
+// Makes sure that the sink is large enough for the data of a file. Requires the index lock.
+static int _grow_sink(moocov_data_size_t size) {
+	if(size <= g_sinkSize) return 1;
+
+	// the smaller sink is left to the files that are still redirected to it
+	void* sink = calloc(1, size);
+	if(!sink) return 0;
+
+	g_sink = sink;
+	g_sinkSize = size;
+	return 1;
 }
 
-// Resets a moocov_file_t object and returns the next item in the chain (if any).
-static moocov_file_t* _reset_file(moocov_file_t* file) {
-	file->linked = 0;
-	memset(file->data, 0, file->dataLength);
+// Points the instrumented code of a file to its active data, or to the sink while data gathering is disabled. Requires the index lock.
+// If the sink can't be allocated, the file keeps gathering data.
+static void _redirect_file(moocov_file_t* file) {
+	void* data = file->active;
+	if(!g_enabled && _grow_sink(_get_data_size(file))) data = g_sink;
 
-	moocov_file_t* next = file->next;
-	file->next = 0;
-	return next;
+	__atomic_store_n(&file->data, data, __ATOMIC_RELEASE);
 }
 
-// Resets the linked list's pointers.
-static void _reset_links() {
-	g_index.head->next = 0;
-	g_index.tail = g_index.head;
+// Gets the data of a file that the hits are registered in while data gathering is enabled. Requires the index lock.
+static void* _get_active(const moocov_file_t* file) {
+	return file->active;
 }
 
-// Clears all accummulated data.
-void moocov_reset() {
+// Takes over the data of a file that the instrumented code has been using so far. Requires the index lock.
+static void _init_active(moocov_file_t* file) {
+	if(!file->active) file->active = file->data;
+}
+
+#else
+
+static void _redirect_file(moocov_file_t* file) { (void)file; }
+static void* _get_active(const moocov_file_t* file) { return file->data; }
+static void _init_active(moocov_file_t* file) { (void)file; }
+
+#endif
+
+#if MOOCOV_MAPPED_COUNTERS || MOOCOV_BUFFERED_COUNTERS
+
+// Moves the hits of a file to another data buffer. Requires the index lock.
+static void _set_active(moocov_file_t* file, void* data) {
+#if MOOCOV_REDIRECTED_DATA
+	file->active = data;
+	_redirect_file(file);
+#else
+	__atomic_store_n(&file->data, data, __ATOMIC_RELEASE);
+#endif
+}
+
+#endif
+
+// The size of the largest blocks that _skip_zero_blocks() checks at once, in bytes.
+#if SIMD_ZERO_SKIP && defined(__AVX2__)
+#	define ZERO_BLOCK_SIZE 32
+#elif SIMD_ZERO_SKIP && defined(__SSE2__)
+#	define ZERO_BLOCK_SIZE 16
+#elif SIMD_ZERO_SKIP
+#	define ZERO_BLOCK_SIZE 8
+#else
+// nothing is skipped, the signals are just checked in blocks of this size
+#	define ZERO_BLOCK_SIZE 64
+#endif
+
+// Skips the blocks of zero bytes at the start of the given range, and returns the start of the first block that isn't all zeros.
+// Most signals are usually never hit, so this lets the dump skip most of the data without looking at the signals one by one.
+static inline const void* _skip_zero_blocks(const void* begin, const void* end) {
+	const unsigned char* p = (const unsigned char*)begin;
+
+#if SIMD_ZERO_SKIP && defined(__AVX2__)
+	for(; (const unsigned char*)end - p >= 32; p += 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i*)p);
+		if(!_mm256_testz_si256(block, block)) break;
+	}
+#endif
+
+#if SIMD_ZERO_SKIP && defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for(; (const unsigned char*)end - p >= 16; p += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*)p);
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)) != 0xFFFF) break;
+	}
+#elif SIMD_ZERO_SKIP
+	for(; (const unsigned char*)end - p >= 8; p += 8) {
+		uint64_t block;
+		memcpy(&block, p, sizeof(block));
+		if(block != 0) break;
+	}
+#else
+	(void)end;
+#endif
+
+	return p;
+}
+
+#if MOOCOV_ATOMIC_COUNTERS
+// Reads a counter and zeroes it in a single step, so that no concurrent hit can get lost in between.
+#	define MOOCOV_TAKE(TYPE, COUNTER) __atomic_exchange_n(&(COUNTER), (TYPE)0, __ATOMIC_RELAXED)
+#else
+#	define MOOCOV_TAKE(TYPE, COUNTER) _moocov_take_plain_##TYPE(&(COUNTER))
+#endif
+
+// Defines the functions working on the data of the files with counters (or flags) of a given type:
+//  - _take_TYPE() reads a counter and zeroes it,
+//  - _find_hit_TYPE() finds the first non-zero counter at or after the given index, or returns the length if there's none,
+//  - _count_hits_TYPE() gets the number of non-zero counters.
+#define MOOCOV_DEFINE_DATA_FUNCTIONS(TYPE) \
+	static inline TYPE _moocov_take_plain_##TYPE(TYPE* counter) { \
+		TYPE value = *counter; \
+		*counter = 0; \
+		return value; \
+	} \
+	\
+	static inline uint64_t _take_##TYPE(void* data, moocov_data_size_t index) { \
+		return MOOCOV_TAKE(TYPE, ((TYPE*)data)[index]); \
+	} \
+	\
+	static inline moocov_data_size_t _find_hit_##TYPE(const void* data, moocov_data_size_t index, moocov_data_size_t length) { \
+		const TYPE* counters = (const TYPE*)data; \
+		\
+		/* hits tend to be close to each other, so first check the rest of the current block one by one */ \
+		moocov_data_size_t blockEnd = (index / (ZERO_BLOCK_SIZE / sizeof(TYPE)) + 1) * (ZERO_BLOCK_SIZE / sizeof(TYPE)); \
+		if(blockEnd > length) blockEnd = length; \
+		\
+		for(; index < blockEnd; ++index) { \
+			if(counters[index] != 0) return index; \
+		} \
+		\
+		/* the block sizes are multiples of the counter size, so this is still the start of a counter */ \
+		index = (const TYPE*)_skip_zero_blocks(counters + index, counters + length) - counters; \
+		\
+		while(index < length && counters[index] == 0) ++index; \
+		return index; \
+	} \
+	\
+	static inline moocov_data_size_t _count_hits_##TYPE(const void* data, moocov_data_size_t length) { \
+		const TYPE* p = (const TYPE*)data; \
+		const TYPE* end = p + length; \
+		moocov_data_size_t count = 0; \
+		\
+		while(p < end) { \
+			p = (const TYPE*)_skip_zero_blocks(p, end); \
+			\
+			/* count the counters of the block that wasn't skipped */ \
+			const TYPE* blockEnd = end - p > (long)(ZERO_BLOCK_SIZE / sizeof(TYPE)) ? p + ZERO_BLOCK_SIZE / sizeof(TYPE) : end; \
+			for(; p < blockEnd; ++p) count += *p != 0; \
+		} \
+		\
+		return count; \
+	}
+
+// flags are handled as 8-bit counters
+MOOCOV_DEFINE_DATA_FUNCTIONS(moocov_data8_t)
+MOOCOV_DEFINE_DATA_FUNCTIONS(moocov_data16_t)
+MOOCOV_DEFINE_DATA_FUNCTIONS(moocov_data_t)
+MOOCOV_DEFINE_DATA_FUNCTIONS(moocov_data64_t)
+
+// Selects the function of the above for the width of the counters of a file.
+#define MOOCOV_DISPATCH_WIDTH(FILE, FUNCTION, ...) \
+	switch(_get_element_size(FILE)) { \
+	case 1: return FUNCTION##_moocov_data8_t(__VA_ARGS__); \
+	case 2: return FUNCTION##_moocov_data16_t(__VA_ARGS__); \
+	case 8: return FUNCTION##_moocov_data64_t(__VA_ARGS__); \
+	default: return FUNCTION##_moocov_data_t(__VA_ARGS__); \
+	}
+
+// Reads a counter (or flag) of a file and zeroes it.
+static inline uint64_t _take(const moocov_file_t* file, void* data, moocov_data_size_t index) {
+	MOOCOV_DISPATCH_WIDTH(file, _take, data, index)
+}
+
+// Finds the first non-zero counter (or set flag) of a file at or after the given index, or returns the length of the data if there's none.
+static inline moocov_data_size_t _find_hit(const moocov_file_t* file, const void* data, moocov_data_size_t index) {
+	MOOCOV_DISPATCH_WIDTH(file, _find_hit, data, index, file->dataLength)
+}
+
+// Gets the number of signals of a file that were hit.
+static inline moocov_data_size_t _count_hits(const moocov_file_t* file, const void* data) {
+	MOOCOV_DISPATCH_WIDTH(file, _count_hits, data, file->dataLength)
+}
+
+#if MOOCOV_SHARDED_COUNTERS
+
+// A thread's private copy of the counters of a file.
+// The counters of a shard are only ever written by their own thread, which increments them without synchronization. So that no hit gets lost or counted twice, dumping or resetting doesn't clear them, but keeps a baseline of the values they were collected at, and only collects what they grew by since then.
+// NOTE: a saturating counter of a shard therefore stays at its maximum once it reaches it, and the later hits of its thread aren't counted.
+typedef struct _moocov_shard_t {
 	moocov_file_t* file;
-	for(file = g_index.head->next; file; file = file->next) {
-		_reset_file(file);
+
+	// the counters the thread registers its hits in: the ones following the shard, or the sink while data gathering is disabled
+	void* data;
+
+	// the neighbouring shards of the same file
+	struct _moocov_shard_t* prevInFile;
+	struct _moocov_shard_t* nextInFile;
+
+	// the next shard of the same thread
+	struct _moocov_shard_t* nextInThread;
+} moocov_shard_t;
+
+// The shards of the current thread.
+static __thread moocov_shard_t* t_shards;
+
+// Used to release the shards of a thread when it exits.
+static pthread_key_t g_shardsKey;
+static pthread_once_t g_shardsKeyOnce = PTHREAD_ONCE_INIT;
+
+// Defines _collect_TYPE(), which adds what the counters of the given type of a shard grew by since their baseline to the counters of its file (unless that's null), and moves the baseline up to them.
+// The growth is computed in the width of the counters, so wrapped counters still give the right number of hits.
+#define MOOCOV_DEFINE_COLLECT(TYPE) \
+	static void _collect_##TYPE(const void* shardCounters, void* shardBaseline, void* data, moocov_data_size_t length, int saturating) { \
+		const TYPE* counters = (const TYPE*)shardCounters; \
+		TYPE* baseline = (TYPE*)shardBaseline; \
+		TYPE* sums = (TYPE*)data; \
+		moocov_data_size_t i; \
+		\
+		for(i = 0; i < length; ++i) { \
+			TYPE value = __atomic_load_n(&counters[i], __ATOMIC_RELAXED); \
+			if(value == baseline[i]) continue; \
+			\
+			if(sums) { \
+				TYPE sum = (TYPE)(sums[i] + (TYPE)(value - baseline[i])); \
+				if(saturating && sum < sums[i]) sum = (TYPE)~(TYPE)0; \
+				sums[i] = sum; \
+			} \
+			\
+			baseline[i] = value; \
+		} \
 	}
 
-	_reset_links();
+MOOCOV_DEFINE_COLLECT(moocov_data8_t)
+MOOCOV_DEFINE_COLLECT(moocov_data16_t)
+MOOCOV_DEFINE_COLLECT(moocov_data_t)
+MOOCOV_DEFINE_COLLECT(moocov_data64_t)
+
+// Gets the counters of a shard, which are allocated right after it.
+static void* _get_shard_counters(moocov_shard_t* shard) {
+	return shard + 1;
 }
 
-// Dumps out accummulated data to disk and then clears all data (same as moocov_reset()).
-// The data files are text files, written to DUMPFILE_NAME. Subsequent dumps append to the same way.
-void moocov_dump() {
-	FILE* fp = fopen((DUMPFILE_NAME), "a");
-	if(!fp) return;
+// Gets the values the counters of a shard were last collected at, which are allocated right after the counters.
+static void* _get_shard_baseline(moocov_shard_t* shard) {
+	return (char*)_get_shard_counters(shard) + _get_data_size(shard->file);
+}
 
-	// a buffer large enough to hold any 64-bit integer in a hexadecimal format
-	char buffer[4 * 16 * sizeof(unsigned long long)];
+// Adds the hits of a shard since it was last collected to the given data of its file, or only forgets them if it's null.
+// Only files with hit counters have shards.
+static void _collect_shard(moocov_shard_t* shard, void* data) {
+	moocov_file_t* file = shard->file;
+	const void* counters = _get_shard_counters(shard);
+	void* baseline = _get_shard_baseline(shard);
+	int saturating = (file->kind & MOOCOV_KIND_SATURATING) != 0;
 
+	switch(_get_element_size(file)) {
+	case 1: _collect_moocov_data8_t(counters, baseline, data, file->dataLength, saturating); break;
+	case 2: _collect_moocov_data16_t(counters, baseline, data, file->dataLength, saturating); break;
+	case 8: _collect_moocov_data64_t(counters, baseline, data, file->dataLength, saturating); break;
+	default: _collect_moocov_data_t(counters, baseline, data, file->dataLength, saturating); break;
+	}
+}
+
+// Collects the shards of all threads into the file's own counters. Requires the index lock.
+static void _collect_shards(moocov_file_t* file) {
+	void* data = _get_active(file);
+
+	moocov_shard_t* shard;
+	for(shard = file->shards; shard; shard = shard->nextInFile) {
+		_collect_shard(shard, data);
+	}
+}
+
+// Clears the shards of all threads of a file. Requires the index lock.
+static void _reset_shards(moocov_file_t* file) {
+	moocov_shard_t* shard;
+	for(shard = file->shards; shard; shard = shard->nextInFile) {
+		_collect_shard(shard, 0);
+	}
+}
+
+// The shards of the threads that have exited, linked through nextInThread. Guarded by the index lock.
+// They are only freed by the next dump or reset, after their hits are collected, as the instrumented code may still run later in the teardown of their thread (e.g. in the destructors of other thread-specific data), and keeps registering its hits in the shards it cached.
+static moocov_shard_t* g_retiredShards;
+
+// Invoked when a thread that has any shards exits: retires its shards, which stay with their files until they are collected.
+static void _release_thread_shards(void* threadShards) {
+	_lock_index();
+
+	// the instrumented code may still allocate new shards for the thread, which are then released in the next round of destructors
+	t_shards = 0;
+
+	moocov_shard_t* shard = (moocov_shard_t*)threadShards;
+	while(shard) {
+		moocov_shard_t* next = shard->nextInThread;
+
+		shard->nextInThread = g_retiredShards;
+		g_retiredShards = shard;
+
+		shard = next;
+	}
+
+	_unlock_index();
+}
+
+// Frees the shards of the threads that have exited. Requires the index lock, and that the shards have been collected (or reset) since they were retired.
+// NOTE: a thread that is still tearing down could register a hit in them after this, if it took the whole dump for it to exit.
+static void _free_retired_shards() {
+	moocov_shard_t* shard = g_retiredShards;
+	while(shard) {
+		moocov_shard_t* next = shard->nextInThread;
+
+		if(shard->prevInFile) shard->prevInFile->nextInFile = shard->nextInFile;
+		else shard->file->shards = shard->nextInFile;
+
+		if(shard->nextInFile) shard->nextInFile->prevInFile = shard->prevInFile;
+
+		free(shard);
+		shard = next;
+	}
+
+	g_retiredShards = 0;
+}
+
+static void _create_shards_key() {
+	pthread_key_create(&g_shardsKey, _release_thread_shards);
+}
+
+#if MOOCOV_REDIRECTED_SHARDS
+
+// Points the instrumented code of a thread to the counters of its shard, or to the sink while data gathering is disabled. Requires the index lock.
+static void _redirect_shard(moocov_shard_t* shard) {
+	void* data = _get_shard_counters(shard);
+	if(!g_enabled && _grow_sink(_get_data_size(shard->file))) data = g_sink;
+
+	__atomic_store_n(&shard->data, data, __ATOMIC_RELAXED);
+}
+
+// Redirects the shards of all threads of a file. Requires the index lock.
+static void _redirect_shards(moocov_file_t* file) {
+	moocov_shard_t* shard;
+	for(shard = file->shards; shard; shard = shard->nextInFile) {
+		_redirect_shard(shard);
+	}
+}
+
+#else
+
+static void _redirect_shard(moocov_shard_t* shard) { (void)shard; }
+
+#endif
+
+// Gets the calling thread's shard of a file, allocating it on first use. Returns null if it can't be allocated.
+static moocov_shard_t* _get_thread_shard(moocov_file_t* file) {
+	// the inline signal functions cache the shards, but _moocov_signal() doesn't
+	moocov_shard_t* shard;
+	for(shard = t_shards; shard; shard = shard->nextInThread) {
+		if(shard->file == file) return shard;
+	}
+
+	// the shard, its counters and their baseline are allocated together
+	shard = (moocov_shard_t*)calloc(1, sizeof(moocov_shard_t) + 2 * _get_data_size(file));
+	if(MOOCOV_UNLIKELY(!shard)) return 0;
+
+	shard->file = file;
+	shard->data = _get_shard_counters(shard);
+
+	_lock_index();
+
+	shard->nextInFile = file->shards;
+	if(file->shards) file->shards->prevInFile = shard;
+	file->shards = shard;
+
+	// data gathering may be disabled already
+	_redirect_shard(shard);
+
+	_unlock_index();
+
+	shard->nextInThread = t_shards;
+	t_shards = shard;
+
+	pthread_once(&g_shardsKeyOnce, _create_shards_key);
+	pthread_setspecific(g_shardsKey, t_shards);
+
+	return shard;
+}
+
+// Out of memory, these fall back to the shared counters, rather than crashing the program.
+#if MOOCOV_REDIRECTED_SHARDS
+
+void** _moocov_get_shard_slot(moocov_file_t* file) {
+	moocov_shard_t* shard = _get_thread_shard(file);
+	return shard ? &shard->data : &file->data;
+}
+
+#else
+
+void* _moocov_get_shard(moocov_file_t* file) {
+	moocov_shard_t* shard = _get_thread_shard(file);
+	return shard ? shard->data : file->data;
+}
+
+#endif
+
+// Gets whether a shard belongs to the current thread.
+static int _is_own_shard(const moocov_shard_t* shard) {
+	const moocov_shard_t* own;
+	for(own = t_shards; own; own = own->nextInThread) {
+		if(own == shard) return 1;
+	}
+
+	return 0;
+}
+
+// Forgets the shards of the threads that don't exist anymore in a forked child, which is all of them but the forking one, and frees them. Requires the index lock.
+// The shards of the current thread are kept, as the instrumented code caches them.
+static void _reset_shard_registry() {
 	moocov_file_t* file;
-	for(file = g_index.head->next; file; file = _reset_file(file)) {
-		fwrite(file->id, sizeof(char), strlen(file->id), fp);
-		fwrite("\n", sizeof(char), 1, fp);
+	for(file = _first_file(); file; file = _next_file(file)) {
+		moocov_shard_t* shard = file->shards;
+		file->shards = 0;
 
-		moocov_data_size_t i;
-		for(i = 0; i < file->dataLength; ++i) {
-			if(file->data[i] != 0) {
-				fwrite(buffer, sizeof(char), render_uint64(i, buffer), fp);
-				fwrite(" ", sizeof(char), 1, fp);
-				fwrite(buffer, sizeof(char), render_uint32(file->data[i], buffer), fp);
-				fwrite("\n", sizeof(char), 1, fp);
-			}
+		while(shard) {
+			moocov_shard_t* next = shard->nextInFile;
+			if(!_is_own_shard(shard)) free(shard);
+			shard = next;
 		}
+	}
+
+	// the retired shards were still with their files, so they have been freed too
+	g_retiredShards = 0;
 
-		fwrite(";\n", sizeof(char), 2, fp);
+	moocov_shard_t* shard;
+	for(shard = t_shards; shard; shard = shard->nextInThread) {
+		file = shard->file;
+
+		shard->prevInFile = 0;
+		shard->nextInFile = file->shards;
+		if(file->shards) file->shards->prevInFile = shard;
+		file->shards = shard;
 	}
+}
+
+#else
+
+static void _collect_shards(moocov_file_t* file) { (void)file; }
+static void _reset_shards(moocov_file_t* file) { (void)file; }
+static void _free_retired_shards() {}
+static void _reset_shard_registry() {}
+
+#if ALLOW_DISABLE
+static void _redirect_shards(moocov_file_t* file) { (void)file; }
+#endif
+
+#endif
+
+#if MOOCOV_MAPPED_COUNTERS
+
+// The counter file of the process, or -1 if it's not open (yet), or couldn't be opened.
+static int g_mapFd = -1;
+static int g_mapFailed;
 
-	fclose(fp);
-	_reset_links();
+// The current size of the counter file.
+static off_t g_mapSize;
+
+// The last chunk of the counter file, which new records are added to.
+static char* g_chunk;
+static moocov_data_size_t g_chunkSize;
+static moocov_data_size_t g_chunkUsed;
+
+static moocov_data_size_t _align_mapped(moocov_data_size_t size) {
+	return (size + MOOCOV_MAPPED_ALIGNMENT - 1) & ~(moocov_data_size_t)(MOOCOV_MAPPED_ALIGNMENT - 1);
 }
 
-// Adds an object to the linked list.
-void _moocov_link(moocov_file_t* file) {
-	if(MOOCOV_UNLIKELY(file->linked)) return;
+// Grows the counter file with a chunk that has room for at least the given number of bytes, and maps it. Requires the index lock.
+static int _map_chunk(moocov_data_size_t minSize) {
+	if(g_mapFd < 0) {
+		char path[256];
+		snprintf(path, sizeof(path), (MAPFILE_NAME_FORMAT), (int)getpid());
+
+#if MAPFILE_SHARED_MEMORY
+		g_mapFd = shm_open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+#else
+		g_mapFd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+#endif
+		if(g_mapFd < 0) return 0;
+	}
 
-	g_index.tail->next = file;
-	g_index.tail = file;
+	moocov_data_size_t pageSize = (moocov_data_size_t)sysconf(_SC_PAGESIZE);
+	moocov_data_size_t size = (sizeof(moocov_mapped_chunk_t) + minSize + pageSize - 1) / pageSize * pageSize;
+	if(size < (MAPFILE_CHUNK_SIZE)) size = (MAPFILE_CHUNK_SIZE);
 
-	file->linked = 1;
+	if(ftruncate(g_mapFd, g_mapSize + (off_t)size) != 0) return 0;
+
+	void* chunk = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, g_mapFd, g_mapSize);
+	if(chunk == MAP_FAILED) return 0;
+
+	moocov_mapped_chunk_t* header = (moocov_mapped_chunk_t*)chunk;
+	memcpy(header->magic, MOOCOV_MAPPED_MAGIC, MOOCOV_MAPPED_MAGIC_LENGTH);
+	header->version = MOOCOV_MAPPED_VERSION;
+	header->size = size;
+
+	g_mapSize += (off_t)size;
+	g_chunk = (char*)chunk;
+	g_chunkSize = size;
+	g_chunkUsed = sizeof(moocov_mapped_chunk_t);
+	return 1;
+}
+
+// Moves the data of a file into a new record of the counter file. Requires the index lock.
+// If the counter file can't be used, the data stays in the static array of the file, so only moocov_dump() can write it.
+static void _map_file(moocov_file_t* file) {
+	if(file->mapped || g_mapFailed) return;
+
+	moocov_data_size_t idLength = file->idLength;
+	moocov_data_size_t dataOffset = _align_mapped(sizeof(moocov_mapped_file_t) + idLength);
+	moocov_data_size_t recordSize = dataOffset + _align_mapped(_get_data_size(file));
+
+	if(!g_chunk || g_chunkUsed + recordSize > g_chunkSize) {
+		if(!_map_chunk(recordSize)) {
+			g_mapFailed = 1;
+			return;
+		}
+	}
+
+	moocov_mapped_file_t* record = (moocov_mapped_file_t*)(g_chunk + g_chunkUsed);
+	record->idLength = (uint32_t)idLength;
+	record->kind = file->kind;
+	record->numSignals = (uint32_t)file->dataLength;
+	memcpy(record + 1, file->id, idLength);
+
+	// keep the hits registered before the file was linked
+	char* data = (char*)record + dataOffset;
+	memcpy(data, _get_active(file), _get_data_size(file));
+
+	// from now on, the instrumented code registers the hits in the counter file
+	_set_active(file, data);
+	__atomic_store_n(&record->size, (uint32_t)recordSize, __ATOMIC_RELEASE);
+
+	g_chunkUsed += recordSize;
+	file->mapped = 1;
+}
+
+// Gives a file of a forked child process its own data, as the parent's counter file is shared with the child. Requires the index lock.
+// Returns 1 if the file's data was mapped; such files are cleared in the process, without touching the parent's data.
+static int _unshare_file(moocov_file_t* file) {
+	if(!file->mapped) return 0;
+
+	// if even this fails, the child keeps adding its hits to the parent's record, as it did before
+	void* data = calloc(1, _get_data_size(file));
+	if(!data) return 1;
+
+	_set_active(file, data);
+	file->mapped = 0;
+
+	_map_file(file);
+	if(file->mapped) free(data);
+
+	return 1;
+}
+
+// Forgets the counter file of the parent process in a forked child, so that the child opens its own. Requires the index lock.
+static void _reset_mapping() {
+	if(g_mapFd >= 0) close(g_mapFd);
+
+	g_mapFd = -1;
+	g_mapFailed = 0;
+	g_mapSize = 0;
+	g_chunk = 0;
+	g_chunkSize = 0;
+	g_chunkUsed = 0;
 }
 
-// Registers a hit on the specified signal. VERY performance-critical.
-void _moocov_signal(moocov_file_t* file, moocov_data_size_t index) {
-#if ALLOW_DISABLE
-	file->data[index] += g_moocov_enabled;
 #else
-	file->data[index]++;
+
+static void _map_file(moocov_file_t* file) { (void)file; }
+static int _unshare_file(moocov_file_t* file) { (void)file; return 0; }
+static void _reset_mapping() {}
+
+#endif
+
+#if MOOCOV_BUFFERED_COUNTERS
+
+// Allocates the spare data buffer of a file. Requires the index lock.
+// If that fails, the file is dumped in place, like in MOOCOV_ATOMIC_COUNTERS mode.
+static void _allocate_spare(moocov_file_t* file) {
+	if(!file->spare) file->spare = calloc(1, _get_data_size(file));
+}
+
+static void _reset_spare(moocov_file_t* file) {
+	if(file->spare) memset(file->spare, 0, _get_data_size(file));
+}
+
+// Makes the spare data buffer of a file the active one, and returns the retired buffer to be dumped. Requires the index lock.
+// Hits that were already underway may still land in the retired buffer, so it's only ever cleared by taking each counter atomically.
+// The hits left in it are then dumped the next time it's retired.
+static void* _retire_data(moocov_file_t* file) {
+	void* retired = _get_active(file);
+	if(!file->spare) return retired;
+
+	_set_active(file, file->spare);
+	file->spare = retired;
+	return retired;
+}
+
+#else
+
+static void _allocate_spare(moocov_file_t* file) { (void)file; }
+static void _reset_spare(moocov_file_t* file) { (void)file; }
+static void* _retire_data(moocov_file_t* file) { return _get_active(file); }
+
 #endif
+
+#if INCREMENTAL_DUMPS
+
+#if MOOCOV_ATOMIC_COUNTERS
+#	define MOOCOV_LOAD(COUNTER) __atomic_load_n(&(COUNTER), __ATOMIC_RELAXED)
+#else
+#	define MOOCOV_LOAD(COUNTER) (COUNTER)
+#endif
+
+// Defines _diff_TYPE(), which adds the changes of counters (or flags) of the given type since the previous dump to the second half of a shadow, and updates the values in its first half.
+// The changes are added, rather than stored, so that they are kept if the dump they were meant for fails. Wrapped counters still give the right change, as it's computed in their own width.
+#define MOOCOV_DEFINE_DIFF(TYPE) \
+	static void _diff_##TYPE(const void* data, void* shadow, moocov_data_size_t length) { \
+		const TYPE* counters = (const TYPE*)data; \
+		TYPE* previous = (TYPE*)shadow; \
+		TYPE* changes = previous + length; \
+		moocov_data_size_t i; \
+		\
+		for(i = 0; i < length; ++i) { \
+			TYPE value = MOOCOV_LOAD(counters[i]); \
+			changes[i] = (TYPE)(changes[i] + (TYPE)(value - previous[i])); \
+			previous[i] = value; \
+		} \
+	}
+
+MOOCOV_DEFINE_DIFF(moocov_data8_t)
+MOOCOV_DEFINE_DIFF(moocov_data16_t)
+MOOCOV_DEFINE_DIFF(moocov_data_t)
+MOOCOV_DEFINE_DIFF(moocov_data64_t)
+
+// Allocates the shadow of a file. Requires the index lock.
+// If that fails, the file is dumped and cleared as without INCREMENTAL_DUMPS, which readers can't tell apart.
+static void _allocate_shadow(moocov_file_t* file) {
+	if(!file->shadow) file->shadow = calloc(2, _get_data_size(file));
+}
+
+static void _reset_shadow(moocov_file_t* file) {
+	if(file->shadow) memset(file->shadow, 0, 2 * _get_data_size(file));
+}
+
+// Gets the data of a file to be dumped: the changes since the previous dump, which get cleared while dumping instead of the data itself. Requires the index lock.
+static void* _diff_data(moocov_file_t* file, void* data) {
+	if(!file->shadow) return data;
+
+	switch(_get_element_size(file)) {
+	case 1: _diff_moocov_data8_t(data, file->shadow, file->dataLength); break;
+	case 2: _diff_moocov_data16_t(data, file->shadow, file->dataLength); break;
+	case 8: _diff_moocov_data64_t(data, file->shadow, file->dataLength); break;
+	default: _diff_moocov_data_t(data, file->shadow, file->dataLength); break;
+	}
+
+	return (char*)file->shadow + _get_data_size(file);
+}
+
+#else
+
+static void _allocate_shadow(moocov_file_t* file) { (void)file; }
+static void _reset_shadow(moocov_file_t* file) { (void)file; }
+static void* _diff_data(moocov_file_t* file, void* data) { (void)file; return data; }
+
+#endif
+
+#if ALLOW_DISABLE
+
+// Enables or disables data gathering, redirecting the files as needed.
+static void _set_enabled(int enabled) {
+	_lock_index();
+
+	g_enabled = enabled;
+
+	moocov_file_t* file;
+	for(file = _first_file(); file; file = _next_file(file)) {
+		// the runtime may not have set up the files yet, if called from a constructor
+		_init_active(file);
+		_redirect_file(file);
+		_redirect_shards(file);
+	}
+
+	_unlock_index();
+}
+
+#endif
+
+void moocov_enable() {
+#if ALLOW_DISABLE
+	_set_enabled(1);
+#endif
+}
+
+void moocov_disable() {
+#if ALLOW_DISABLE
+	_set_enabled(0);
+#endif
+}
+
+// Clears the data arrays of all files in the sections at once.
+// Returns 0 if that isn't possible, as the files may keep their data elsewhere, and it has to be cleared file by file.
+static int _reset_sections() {
+#if MOOCOV_MAPPED_COUNTERS || MOOCOV_BUFFERED_COUNTERS
+	return 0;
+#else
+	const moocov_module_t* module;
+	for(module = g_modules; module; module = module->next) {
+		if(module->counts != module->countsEnd) memset(module->counts, 0, module->countsEnd - module->counts);
+		if(module->flags != module->flagsEnd) memset(module->flags, 0, module->flagsEnd - module->flags);
+	}
+
+	return 1;
+#endif
+}
+
+// Resets the data of a file, except for its data array if that has already been cleared. Requires the index lock.
+static void _reset_file(moocov_file_t* file, int dataCleared) {
+	if(!dataCleared) memset(_get_active(file), 0, _get_data_size(file));
+	_reset_shards(file);
+	_reset_spare(file);
+}
+
+// Clears the data of all files. Requires the index lock.
+// In a forked child, the files sharing their data with the parent get their own instead.
+static void _reset_files(int forked) {
+	int sectionsCleared = _reset_sections();
+
+	moocov_file_t* file;
+	for(file = _first_file(); file; file = _next_file(file)) {
+		_reset_shadow(file);
+
+		if(forked && _unshare_file(file)) continue;
+		_reset_file(file, sectionsCleared && _is_section_file(file));
+	}
+}
+
+// Clears all accummulated data. The files stay registered.
+void moocov_reset() {
+	_lock_index();
+	_reset_files(0);
+	_free_retired_shards();
+	_unlock_index();
+}
+
+// The longest name of a context kept by moocov_set_context(), including the null terminator. Longer ones are cut off.
+#define CONTEXT_NAME_SIZE 256
+
+// The name of the active context, which labels the dumps, or an empty string if there's none. Guarded by the index lock.
+static char g_context[CONTEXT_NAME_SIZE];
+static size_t g_contextLength;
+
+// The buffer the dumps are rendered into. It's kept from one dump to the next, so that it doesn't have to be allocated (and its pages faulted in) every time.
+static char* g_dumpBuffer;
+static size_t g_dumpBufferSize;
+
+// Guards the dump buffer. Serializes the dumps, as they render into the buffer with the index lock held, but write it out after releasing it.
+static pthread_mutex_t g_dumpLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Appends a rendered dump to the data file, which is opened with O_APPEND.
+// The dump is passed to a single write() (unless that gets interrupted), so that the dumps of processes sharing the data file don't interleave.
+// Returns 0 if it couldn't be written completely.
+static int _write_dump(int fd, const char* data, size_t size) {
+	while(size > 0) {
+		ssize_t written = write(fd, data, size);
+		if(written < 0) {
+			if(errno == EINTR) continue;
+			return 0;
+		}
+
+		data += written;
+		size -= (size_t)written;
+	}
+
+	return 1;
+}
+
+// Makes sure that the dump buffer can hold the given number of bytes. Requires the dump lock.
+static int _grow_dump_buffer(size_t size) {
+	if(size <= g_dumpBufferSize) return 1;
+
+	// the old contents don't need to be kept
+	free(g_dumpBuffer);
+	g_dumpBuffer = (char*)malloc(size);
+	g_dumpBufferSize = g_dumpBuffer ? size : 0;
+	return g_dumpBuffer != 0;
+}
+
+#if TEXT_DUMPFILE || DUMP_SIGNAL
+
+// The buffer a dump in the text format is rendered into, so that the dump can be written at once.
+// It's made large enough for the dump before rendering it: for moocov_dump(), the hits are counted first, and in the signal handler, which mustn't allocate, it's preallocated for the largest dump.
+typedef struct {
+	char* data;
+	size_t size;
+	size_t used;
+} moocov_text_buffer_t;
+
+// The longest line of a text dump, apart from the file IDs: two 64-bit numbers in hexadecimal, a space and a line break.
+#define MOOCOV_TEXT_LINE_SIZE (2 * 16 + 2)
+
+// Gets the size of the text dump of a file with the given number of signals hit: its ID line, a line for each signal and the closing ";" line.
+static size_t _get_text_dump_size(moocov_file_t* file, moocov_data_size_t numHits) {
+	size_t idLength = file->idLength ? file->idLength : strlen(file->id);
+	return idLength + 3 + (size_t)numHits * MOOCOV_TEXT_LINE_SIZE + 2;
+}
+
+// Makes room for the given number of bytes at the end of a text buffer, and returns where they go.
+// Returns null if there isn't enough room, which only happens if the buffer wasn't made large enough for the dump.
+static char* _reserve_text(moocov_text_buffer_t* buffer, size_t length) {
+	if(MOOCOV_UNLIKELY(buffer->used + length > buffer->size)) return 0;
+	return buffer->data + buffer->used;
+}
+
+static void _append_text(moocov_text_buffer_t* buffer, const char* text, size_t length) {
+	char* out = _reserve_text(buffer, length);
+	if(out) {
+		memcpy(out, text, length);
+		buffer->used += length;
+	}
+}
+
+// Defines _dump_counts_TYPE(), which writes the first given number of non-zero counters of the given type of a file as "<signal index> <hit count>" lines, and clears them.
+// Each line is rendered right into the buffer.
+#define MOOCOV_DEFINE_DUMP_COUNTS(TYPE) \
+	static void _dump_counts_##TYPE(moocov_file_t* file, void* data, moocov_data_size_t numHits, moocov_text_buffer_t* out) { \
+		TYPE* counters = (TYPE*)data; \
+		moocov_data_size_t i; \
+		\
+		for(i = _find_hit_##TYPE(data, 0, file->dataLength); i < file->dataLength && numHits > 0; i = _find_hit_##TYPE(data, i + 1, file->dataLength), --numHits) { \
+			char* line = _reserve_text(out, MOOCOV_TEXT_LINE_SIZE); \
+			if(MOOCOV_UNLIKELY(!line)) return; \
+			\
+			char* p = line; \
+			p += render_uint64(i, p); \
+			*p++ = ' '; \
+			p += render_uint64(MOOCOV_TAKE(TYPE, counters[i]), p); \
+			*p++ = '\n'; \
+			\
+			out->used += p - line; \
+		} \
+	}
+
+MOOCOV_DEFINE_DUMP_COUNTS(moocov_data8_t)
+MOOCOV_DEFINE_DUMP_COUNTS(moocov_data16_t)
+MOOCOV_DEFINE_DUMP_COUNTS(moocov_data_t)
+MOOCOV_DEFINE_DUMP_COUNTS(moocov_data64_t)
+
+static void _dump_counts(moocov_file_t* file, void* data, moocov_data_size_t numHits, moocov_text_buffer_t* out) {
+	switch(_get_element_size(file)) {
+	case 1: _dump_counts_moocov_data8_t(file, data, numHits, out); break;
+	case 2: _dump_counts_moocov_data16_t(file, data, numHits, out); break;
+	case 8: _dump_counts_moocov_data64_t(file, data, numHits, out); break;
+	default: _dump_counts_moocov_data_t(file, data, numHits, out); break;
+	}
+}
+
+// Writes the first given number of set flags of a MOOCOV_KIND_FLAGS file as "<signal index>" lines, and clears them.
+static void _dump_flags(moocov_file_t* file, void* data, moocov_data_size_t numHits, moocov_text_buffer_t* out) {
+	moocov_data_size_t i;
+	for(i = _find_hit(file, data, 0); i < file->dataLength && numHits > 0; i = _find_hit(file, data, i + 1), --numHits) {
+		if(_take(file, data, i)) {
+			char* line = _reserve_text(out, MOOCOV_TEXT_LINE_SIZE);
+			if(MOOCOV_UNLIKELY(!line)) return;
+
+			char* p = line;
+			p += render_uint64(i, p);
+			*p++ = '\n';
+
+			out->used += p - line;
+		}
+	}
+}
+
+// Writes the "@<context>" line that starts a text dump if a context is active (file IDs can't start with an @). Requires the index lock.
+static void _dump_text_context(moocov_text_buffer_t* out) {
+	if(g_contextLength > 0) {
+		_append_text(out, "@", 1);
+		_append_text(out, g_context, g_contextLength);
+		_append_text(out, "\n", 1);
+	}
+}
+
+// Writes (at most) the given number of signals a file has hit in the text format, and clears them.
+// The file starts with a line containing its ID, followed by " f" for MOOCOV_KIND_FLAGS files, and ends with a ";" line.
+static void _dump_file_text(moocov_file_t* file, void* data, moocov_data_size_t numHits, moocov_text_buffer_t* out) {
+	_append_text(out, file->id, file->idLength);
+
+	if(file->kind == MOOCOV_KIND_FLAGS) {
+		_append_text(out, " f\n", 3);
+		_dump_flags(file, data, numHits, out);
+	} else {
+		_append_text(out, "\n", 1);
+		_dump_counts(file, data, numHits, out);
+	}
+
+	_append_text(out, ";\n", 2);
+}
+
+#endif
+
+#if TEXT_DUMPFILE
+
+// Gets the size of the "@<context>" line that starts a text dump if a context is active, and of the empty line that ends it. Requires the index lock.
+static size_t _get_text_frame_size() {
+	return (g_contextLength > 0 ? 1 + g_contextLength + 1 : 0) + 1;
+}
+
+// A file to be written out by _dump_text().
+typedef struct {
+	moocov_file_t* file;
+	void* data;
+	moocov_data_size_t numHits;
+} moocov_text_file_t;
+
+// Renders the data of all files in the text format into the dump buffer, and clears it. Returns the rendered dump, and the number of files in it. Requires the dump lock.
+// Files that have no hits are left out. The dump ends with an empty line, so that readers can tell consecutive dumps apart.
+// The hits are counted first, so that the buffer can be grown before clearing any of them, and only the hits that were counted are cleared. Hits on other threads that happen during the dump are kept for the next one.
+static char* _dump_text(size_t* size, moocov_data_size_t* numFiles) {
+	_lock_index();
+
+	moocov_data_size_t numLinked = 0;
+
+	moocov_file_t* file;
+	for(file = _first_file(); file; file = _next_file(file)) ++numLinked;
+
+	moocov_text_file_t* dumped = (moocov_text_file_t*)malloc(numLinked * sizeof(moocov_text_file_t) + 1);
+	if(MOOCOV_UNLIKELY(!dumped)) {
+		// keep the data for the next dump
+		_unlock_index();
+		return 0;
+	}
+
+	moocov_data_size_t numDumped = 0;
+	size_t textSize = _get_text_frame_size();
+
+	for(file = _first_file(); file; file = _next_file(file)) {
+		moocov_text_file_t* current = &dumped[numDumped];
+		current->file = file;
+
+		if(file->kind != MOOCOV_KIND_FLAGS) _collect_shards(file);
+		current->data = _diff_data(file, _retire_data(file));
+
+		current->numHits = _count_hits(file, current->data);
+		if(current->numHits == 0) continue;
+
+		++numDumped;
+		textSize += _get_text_dump_size(file, current->numHits);
+	}
+
+	if(MOOCOV_UNLIKELY(!_grow_dump_buffer(textSize))) {
+		_unlock_index();
+		free(dumped);
+		return 0;
+	}
+
+	moocov_text_buffer_t text = { g_dumpBuffer, textSize, 0 };
+	_dump_text_context(&text);
+
+	moocov_data_size_t i;
+	for(i = 0; i < numDumped; ++i) {
+		_dump_file_text(dumped[i].file, dumped[i].data, dumped[i].numHits, &text);
+	}
+
+	_append_text(&text, "\n", 1);
+
+	_free_retired_shards();
+	_unlock_index();
+
+	free(dumped);
+
+	*size = text.used;
+	*numFiles = numDumped;
+	return text.data;
+}
+
+#endif
+
+#if !TEXT_DUMPFILE
+
+// the payloads are written with the sizes of the runtime's data types
+typedef char moocov_assert_counter_size[sizeof(moocov_data_t) == sizeof(uint32_t) ? 1 : -1];
+typedef char moocov_assert_flag_size[sizeof(moocov_flag_t) == sizeof(uint8_t) ? 1 : -1];
+
+// Gets the size of the payload of a file table entry, in bytes.
+static moocov_data_size_t _get_payload_size(const moocov_dump_file_t* entry) {
+	moocov_data_size_t elementSize = MOOCOV_KIND_ELEMENT_SIZE(entry->kind);
+
+	if(entry->encoding == MOOCOV_DUMP_DENSE) {
+		return (moocov_data_size_t)entry->numSignals * elementSize;
+	}
+
+	if(entry->encoding == MOOCOV_DUMP_RUNS) {
+		// an upper bound, as numRecords is still the number of hits, which is never less than the number of runs
+		moocov_data_size_t numRuns = entry->numRecords;
+		if(numRuns > entry->numSignals - entry->numRecords + 1) numRuns = entry->numSignals - entry->numRecords + 1;
+
+		moocov_data_size_t size = numRuns * 2 * MOOCOV_VARINT_MAX_SIZE(sizeof(uint32_t));
+		if(entry->kind != MOOCOV_KIND_FLAGS) size += (moocov_data_size_t)entry->numRecords * MOOCOV_VARINT_MAX_SIZE(elementSize);
+		return size;
+	}
+
+	return (moocov_data_size_t)entry->numRecords * (entry->kind == MOOCOV_KIND_FLAGS ? sizeof(uint32_t) : sizeof(uint32_t) + elementSize);
+}
+
+// Picks the encoding resulting in the smaller payload for a file table entry.
+// With COMPACT_DUMPFILE, that's always MOOCOV_DUMP_RUNS, whose size is only known once packed.
+static void _choose_encoding(const moocov_file_t* file, const void* data, moocov_dump_file_t* entry) {
+	entry->encoding = COMPACT_DUMPFILE ? MOOCOV_DUMP_RUNS : MOOCOV_DUMP_SPARSE;
+	entry->numRecords = (uint32_t)_count_hits(file, data);
+	if(COMPACT_DUMPFILE) return;
+
+	if(_get_payload_size(entry) > _get_data_size(file)) {
+		entry->encoding = MOOCOV_DUMP_DENSE;
+		entry->numRecords = entry->numSignals;
+	}
+}
+
+#if COMPACT_DUMPFILE
+
+// Writes an unsigned integer as a varint (see MOOCOV_DUMP_RUNS). Returns the end of it.
+static char* _pack_varint(char* out, uint64_t value) {
+	while(value >= 0x80) {
+		*out++ = (char)(value | 0x80);
+		value >>= 7;
+	}
+
+	*out++ = (char)value;
+	return out;
+}
+
+// Defines _pack_runs_TYPE(), which writes the MOOCOV_DUMP_RUNS payload of a file with counters (or flags) of the given type, zeroing them, and returns the end of the payload.
+#define MOOCOV_DEFINE_PACK_RUNS(TYPE) \
+	static char* _pack_runs_##TYPE(moocov_file_t* file, void* data, moocov_dump_file_t* entry, char* out) { \
+		TYPE* counters = (TYPE*)data; \
+		int withCounts = file->kind != MOOCOV_KIND_FLAGS; \
+		moocov_data_size_t end = 0; \
+		uint32_t numRuns = 0; \
+		\
+		/* as with sparse records, only as many hits as were counted fit, and the rest are left for the next dump */ \
+		moocov_data_size_t left = entry->numRecords; \
+		moocov_data_size_t i = _find_hit_##TYPE(data, 0, file->dataLength); \
+		while(i < file->dataLength && left > 0) { \
+			moocov_data_size_t runEnd = i + 1; \
+			while(runEnd < file->dataLength && runEnd - i < left && counters[runEnd] != 0) ++runEnd; \
+			\
+			out = _pack_varint(out, i - end); \
+			out = _pack_varint(out, runEnd - i); \
+			left -= runEnd - i; \
+			\
+			for(; i < runEnd; ++i) { \
+				TYPE value = MOOCOV_TAKE(TYPE, counters[i]); \
+				if(withCounts) out = _pack_varint(out, value); \
+			} \
+			\
+			end = runEnd; \
+			++numRuns; \
+			i = _find_hit_##TYPE(data, runEnd, file->dataLength); \
+		} \
+		\
+		entry->numRecords = numRuns; \
+		return out; \
+	}
+
+MOOCOV_DEFINE_PACK_RUNS(moocov_data8_t)
+MOOCOV_DEFINE_PACK_RUNS(moocov_data16_t)
+MOOCOV_DEFINE_PACK_RUNS(moocov_data_t)
+MOOCOV_DEFINE_PACK_RUNS(moocov_data64_t)
+
+static char* _pack_runs(moocov_file_t* file, void* data, moocov_dump_file_t* entry, char* out) {
+	MOOCOV_DISPATCH_WIDTH(file, _pack_runs, file, data, entry, out)
+}
+
+#else
+
+static char* _pack_uint32(char* out, uint32_t value) {
+	memcpy(out, &value, sizeof(value));
+	return out + sizeof(value);
+}
+
+// Defines _pack_counts_TYPE(), which writes the payload of a file with hit counters of the given type, zeroing the counters, and returns the end of the payload.
+// The loops are generated for each type, so that the width isn't checked counter by counter.
+#define MOOCOV_DEFINE_PACK_COUNTS(TYPE) \
+	static char* _pack_counts_##TYPE(moocov_file_t* file, void* data, moocov_dump_file_t* entry, char* out) { \
+		TYPE* counters = (TYPE*)data; \
+		TYPE value; \
+		moocov_data_size_t i; \
+		\
+		if(entry->encoding == MOOCOV_DUMP_DENSE) { \
+			for(i = 0; i < file->dataLength; ++i) { \
+				value = MOOCOV_TAKE(TYPE, counters[i]); \
+				memcpy(out, &value, sizeof(value)); \
+				out += sizeof(value); \
+			} \
+			\
+			return out; \
+		} \
+		\
+		/* signals hit on other threads since the hits were counted are left for the next dump, as there's no room for them */ \
+		uint32_t numRecords = 0; \
+		for(i = _find_hit_##TYPE(data, 0, file->dataLength); i < file->dataLength && numRecords < entry->numRecords; i = _find_hit_##TYPE(data, i + 1, file->dataLength)) { \
+			out = _pack_uint32(out, (uint32_t)i); \
+			value = MOOCOV_TAKE(TYPE, counters[i]); \
+			memcpy(out, &value, sizeof(value)); \
+			out += sizeof(value); \
+			++numRecords; \
+		} \
+		\
+		entry->numRecords = numRecords; \
+		return out; \
+	}
+
+MOOCOV_DEFINE_PACK_COUNTS(moocov_data8_t)
+MOOCOV_DEFINE_PACK_COUNTS(moocov_data16_t)
+MOOCOV_DEFINE_PACK_COUNTS(moocov_data_t)
+MOOCOV_DEFINE_PACK_COUNTS(moocov_data64_t)
+
+static char* _pack_counts(moocov_file_t* file, void* data, moocov_dump_file_t* entry, char* out) {
+	MOOCOV_DISPATCH_WIDTH(file, _pack_counts, file, data, entry, out)
+}
+
+
+// Writes the payload of a MOOCOV_KIND_FLAGS file, clearing the flags. Returns the end of the payload.
+static char* _pack_flags(moocov_file_t* file, void* data, moocov_dump_file_t* entry, char* out) {
+	moocov_data_size_t i;
+
+	if(entry->encoding == MOOCOV_DUMP_DENSE) {
+		for(i = 0; i < file->dataLength; ++i) {
+			*out++ = (char)_take_moocov_data8_t(data, i);
+		}
+
+		return out;
+	}
+
+	uint32_t numRecords = 0;
+	for(i = _find_hit_moocov_data8_t(data, 0, file->dataLength); i < file->dataLength && numRecords < entry->numRecords; i = _find_hit_moocov_data8_t(data, i + 1, file->dataLength)) {
+		if(_take_moocov_data8_t(data, i)) {
+			out = _pack_uint32(out, (uint32_t)i);
+			++numRecords;
+		}
+	}
+
+	entry->numRecords = numRecords;
+	return out;
+}
+
+#endif
+
+// A file to be written out by _dump_binary().
+typedef struct {
+	moocov_file_t* file;
+	void* data;
+	moocov_dump_file_t entry;
+} moocov_dumped_file_t;
+
+// Renders the data of all files in the binary format described in dumpformat.h into the dump buffer, and clears it. Returns the rendered block, and the number of files in it. Requires the dump lock.
+// Files that have no hits are left out.
+static char* _dump_binary(size_t* size, moocov_data_size_t* numFiles) {
+	_lock_index();
+
+	moocov_data_size_t numLinked = 0;
+
+	moocov_file_t* file;
+	for(file = _first_file(); file; file = _next_file(file)) ++numLinked;
+
+	moocov_dumped_file_t* dumped = (moocov_dumped_file_t*)malloc(numLinked * sizeof(moocov_dumped_file_t) + 1);
+	if(MOOCOV_UNLIKELY(!dumped)) {
+		// keep the data for the next dump
+		_unlock_index();
+		return 0;
+	}
+
+	moocov_dump_header_t header;
+	memcpy(header.magic, MOOCOV_DUMP_MAGIC, MOOCOV_DUMP_MAGIC_LENGTH);
+	header.version = g_contextLength > 0 ? MOOCOV_DUMP_VERSION : MOOCOV_DUMP_VERSION_WITHOUT_CONTEXT;
+	header.numFiles = 0;
+	header.idTableSize = 0;
+
+	uint32_t contextLength = (uint32_t)g_contextLength;
+	size_t contextSize = contextLength > 0 ? sizeof(contextLength) + contextLength : 0;
+
+	moocov_data_size_t payloadSize = 0;
+
+	// first decide what to write, so that the buffer can be allocated with the exact size
+	for(file = _first_file(); file; file = _next_file(file)) {
+		moocov_dumped_file_t* current = &dumped[header.numFiles];
+		current->file = file;
+
+		if(file->kind != MOOCOV_KIND_FLAGS) _collect_shards(file);
+		current->data = _diff_data(file, _retire_data(file));
+
+		moocov_dump_file_t* entry = &current->entry;
+		entry->kind = file->kind;
+		entry->reserved = 0;
+		entry->numSignals = (uint32_t)file->dataLength;
+
+		_choose_encoding(file, current->data, entry);
+		if(entry->encoding != MOOCOV_DUMP_DENSE && entry->numRecords == 0) continue;
+
+		entry->idOffset = header.idTableSize;
+		entry->idLength = file->idLength;
+
+		++header.numFiles;
+		header.idTableSize += entry->idLength;
+		payloadSize += _get_payload_size(entry);
+	}
+
+	if(MOOCOV_UNLIKELY(!_grow_dump_buffer(sizeof(header) + contextSize + header.numFiles * sizeof(moocov_dump_file_t) + header.idTableSize + payloadSize))) {
+		_unlock_index();
+		free(dumped);
+		return 0;
+	}
+
+	char* buffer = g_dumpBuffer;
+
+	memcpy(buffer, &header, sizeof(header));
+
+	if(contextSize > 0) {
+		memcpy(buffer + sizeof(header), &contextLength, sizeof(contextLength));
+		memcpy(buffer + sizeof(header) + sizeof(contextLength), g_context, contextLength);
+	}
+
+	// nothing is aligned after the name of the context
+	char* table = buffer + sizeof(header) + contextSize;
+	char* ids = table + header.numFiles * sizeof(moocov_dump_file_t);
+	char* payload = ids + header.idTableSize;
+
+	uint32_t i;
+	for(i = 0; i < header.numFiles; ++i) {
+		moocov_dumped_file_t* current = &dumped[i];
+		file = current->file;
+
+		memcpy(ids + current->entry.idOffset, file->id, current->entry.idLength);
+
+#if COMPACT_DUMPFILE
+		payload = _pack_runs(file, current->data, &current->entry, payload);
+#else
+		if(file->kind == MOOCOV_KIND_FLAGS) {
+			payload = _pack_flags(file, current->data, &current->entry, payload);
+		} else {
+			payload = _pack_counts(file, current->data, &current->entry, payload);
+		}
+#endif
+
+		// the number of records may only go down while packing
+		memcpy(table + i * sizeof(moocov_dump_file_t), &current->entry, sizeof(moocov_dump_file_t));
+	}
+
+	_free_retired_shards();
+	_unlock_index();
+
+	free(dumped);
+
+	*size = payload - buffer;
+	*numFiles = header.numFiles;
+	return buffer;
+}
+
+#endif
+
+// The size of the buffer that the path of the data file is expanded into.
+#define DUMP_PATH_SIZE 4096
+
+// Renders a number in decimal into a buffer of at least 21 bytes.
+// Used instead of snprintf(), which isn't async-signal-safe, and render_uint64(), which reverses the digits.
+static const char* _render_decimal(unsigned long long n, char* buffer) {
+	char digits[20];
+	size_t length = 0;
+
+	do {
+		digits[length++] = (char)('0' + n % 10);
+		n /= 10;
+	} while(n != 0);
+
+	size_t i;
+	for(i = 0; i < length; ++i) buffer[i] = digits[length - 1 - i];
+	buffer[length] = 0;
+	return buffer;
+}
+
+// Gets the expansion of a placeholder of the data file path (see DUMPFILE_NAME) into a buffer of at least 256 bytes.
+// Only uses async-signal-safe functions, as it's also called from the DUMP_SIGNAL handler.
+static const char* _expand_placeholder(char placeholder, char* buffer) {
+	struct utsname names;
+	struct timespec now;
+
+	switch(placeholder) {
+	case 'p':
+		return _render_decimal((unsigned long long)getpid(), buffer);
+
+	case 'h':
+		if(uname(&names) != 0) return "unknown";
+		return strcpy(buffer, names.nodename);
+
+	case 't':
+		if(clock_gettime(CLOCK_REALTIME, &now) != 0) return "0";
+		return _render_decimal((unsigned long long)now.tv_sec, buffer);
+
+	case '%':
+		return "%";
+
+	default:
+		// unknown placeholders are kept as they are
+		buffer[0] = '%';
+		buffer[1] = placeholder;
+		buffer[2] = 0;
+		return buffer;
+	}
+}
+
+// Gets the path of the data file before expanding the placeholders.
+static const char* _get_dump_pattern() {
+	const char* pattern = getenv("MOOCOV_DUMP_FILE");
+	return pattern && *pattern ? pattern : (DUMPFILE_NAME);
+}
+
+// Gets the path of the data file, with the placeholders expanded into a buffer of DUMP_PATH_SIZE bytes. Returns null if the path doesn't fit.
+// The placeholders are expanded on every dump, as a forked child has a different process ID.
+static const char* _get_dump_path(const char* pattern, char* buffer) {
+	size_t length = 0;
+	for(; *pattern; ++pattern) {
+		char expansionBuffer[256];
+		const char* expansion = expansionBuffer;
+
+		if(*pattern == '%' && pattern[1]) {
+			expansion = _expand_placeholder(*++pattern, expansionBuffer);
+		} else {
+			expansionBuffer[0] = *pattern;
+			expansionBuffer[1] = 0;
+		}
+
+		size_t expansionLength = strlen(expansion);
+		if(length + expansionLength >= DUMP_PATH_SIZE) return 0;
+
+		memcpy(buffer + length, expansion, expansionLength);
+		length += expansionLength;
+	}
+
+	buffer[length] = 0;
+	return buffer;
+}
+
+// Writes out the accummulated data of the registered files, and clears it. Requires the dump lock.
+// The data is written in the binary format by default, or in the text format if TEXT_DUMPFILE is set. Subsequent dumps append to the same file.
+// Each dump is rendered into the dump buffer first, so that the index lock is not held during I/O, and it gets written at once.
+// If skipEmpty is set, nothing is written when no file has hits. Returns 0 if the dump failed.
+static int _dump_locked(const char* path, int skipEmpty) {
+	if(!path) return 0;
+
+	// opened before clearing the data, so that it's kept for the next dump if the data file can't be written
+	int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if(fd < 0) return 0;
+
+	size_t size = 0;
+	moocov_data_size_t numFiles = 0;
+
+#if TEXT_DUMPFILE
+	char* buffer = _dump_text(&size, &numFiles);
+#else
+	char* buffer = _dump_binary(&size, &numFiles);
+#endif
+
+	int written = buffer && ((skipEmpty && numFiles == 0) || _write_dump(fd, buffer, size));
+
+	close(fd);
+	return written;
+}
+
+static int _dump_to(const char* path) {
+	pthread_mutex_lock(&g_dumpLock);
+	int written = _dump_locked(path, 0);
+	pthread_mutex_unlock(&g_dumpLock);
+
+	return written;
+}
+
+// Dumps out accummulated data to disk and then clears all data (same as moocov_reset()), or with INCREMENTAL_DUMPS, only what has changed since the previous dump, keeping the data.
+void moocov_dump() {
+	char path[DUMP_PATH_SIZE];
+	_dump_to(_get_dump_path(_get_dump_pattern(), path));
+}
+
+// Dumps the hits so far under the active context, and makes the given one active, or none if it's null or empty.
+// The name is copied, with line breaks replaced by spaces, so that it can't break the text format.
+// If the dump fails, the active context is kept, so that the hits aren't attributed to the new one, and 0 is returned. If there are no hits to attribute to the active context, nothing is written.
+int moocov_set_context(const char* name) {
+	char path[DUMP_PATH_SIZE];
+
+	// held until the new context is active, so that the dumps of other threads can't get between, and context switches from several threads can't interleave
+	pthread_mutex_lock(&g_dumpLock);
+
+	if(!_dump_locked(_get_dump_path(_get_dump_pattern(), path), 1)) {
+		pthread_mutex_unlock(&g_dumpLock);
+		return 0;
+	}
+
+	_lock_index();
+
+	size_t length = 0;
+	for(; name && name[length] && length < sizeof(g_context) - 1; ++length) {
+		g_context[length] = name[length] == '\n' || name[length] == '\r' ? ' ' : name[length];
+	}
+
+	g_context[length] = 0;
+	g_contextLength = length;
+
+	_unlock_index();
+
+	pthread_mutex_unlock(&g_dumpLock);
+	return 1;
+}
+
+#if DUMP_SIGNAL
+
+// The preallocated buffer of the dumps triggered by DUMP_SIGNAL. Guarded by the index lock.
+static char* g_signalDumpBuffer;
+static size_t g_signalDumpBufferSize;
+
+// The size of the longest dump the registered files can make, starting with the context line and the closing empty line. Guarded by the index lock.
+static size_t g_signalDumpSize = 1 + CONTEXT_NAME_SIZE + 1;
+
+// Grows the buffer of the signal dumps for the longest dump of the given files, which are being registered. Requires the index lock.
+// If it can't be grown, the signal dumps are skipped (keeping the data), rather than written in pieces that could interleave with the dumps of other processes.
+static void _reserve_signal_dump(moocov_file_t* files, moocov_file_t* filesEnd) {
+	moocov_file_t* file;
+	for(file = files; file < filesEnd; ++file) {
+		g_signalDumpSize += _get_text_dump_size(file, file->dataLength);
+	}
+
+	if(g_signalDumpSize <= g_signalDumpBufferSize) return;
+
+	// grown in steps, as the files outside the sections are registered one by one
+	size_t size = g_signalDumpSize > g_signalDumpBufferSize * 2 ? g_signalDumpSize : g_signalDumpBufferSize * 2;
+	char* buffer = (char*)malloc(size);
+	if(!buffer) return;
+
+	free(g_signalDumpBuffer);
+	g_signalDumpBuffer = buffer;
+	g_signalDumpBufferSize = size;
+}
+
+// The path of the data file, as getenv() isn't async-signal-safe.
+static const char* g_signalDumpPattern;
+
+// Writes the data of all files in the text format into a buffer that can hold the largest dump, and clears it. Requires the index lock.
+// Files that have no hits are left out. The dump ends with an empty line, so that readers can tell consecutive dumps apart.
+// Only uses async-signal-safe functions, as it's called from the DUMP_SIGNAL handler.
+static void _dump_text_preallocated(moocov_text_buffer_t* out) {
+	_dump_text_context(out);
+
+	// as the buffer can't run out, the counters can be zeroed one by one as they are written out, so that hits on other threads that happen during the dump are kept for the next one
+	moocov_file_t* file;
+	for(file = _first_file(); file; file = _next_file(file)) {
+		if(file->kind != MOOCOV_KIND_FLAGS) _collect_shards(file);
+
+		void* data = _diff_data(file, _retire_data(file));
+		if(_find_hit(file, data, 0) == file->dataLength) continue;
+
+		_dump_file_text(file, data, file->dataLength, out);
+	}
+
+	_append_text(out, "\n", 1);
+}
+
+// Dumps the data in the text format, with async-signal-safe functions only.
+// If the index lock is held, possibly by the very thread the signal interrupted, the dump is left to the thread releasing the lock.
+static void _signal_dump() {
+	__atomic_store_n(&g_signalDumpPending, 1, __ATOMIC_RELAXED);
+	if(!_try_lock_index()) return;
+
+	__atomic_store_n(&g_signalDumpPending, 0, __ATOMIC_RELAXED);
+
+	char path[DUMP_PATH_SIZE];
+	const char* expandedPath = _get_dump_path(g_signalDumpPattern, path);
+
+	int fd = expandedPath && g_signalDumpSize <= g_signalDumpBufferSize ? open(expandedPath, O_WRONLY | O_CREAT | O_APPEND, 0644) : -1;
+	if(fd >= 0) {
+		moocov_text_buffer_t text = { g_signalDumpBuffer, g_signalDumpBufferSize, 0 };
+		_dump_text_preallocated(&text);
+		_write_dump(fd, text.data, text.used);
+
+		close(fd);
+	}
+
+	_unlock_index();
+}
+
+static void _handle_dump_signal(int signal) {
+	(void)signal;
+
+	int savedErrno = errno;
+	_signal_dump();
+	errno = savedErrno;
+}
+
+// Installs the handler of DUMP_SIGNAL.
+static void _install_signal_dump() {
+	g_signalDumpPattern = _get_dump_pattern();
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = _handle_dump_signal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+
+	sigaction((DUMP_SIGNAL), &action, 0);
+}
+
+#endif
+
+#if MOOCOV_BUFFERED_COUNTERS
+
+static pthread_once_t g_backgroundDumpOnce = PTHREAD_ONCE_INIT;
+
+// The body of the background dump thread: dumps every given number of seconds.
+static void* _background_dump(void* interval) {
+	char path[DUMP_PATH_SIZE];
+
+	for(;;) {
+		struct timespec remaining = { (time_t)(uintptr_t)interval, 0 };
+		while(nanosleep(&remaining, &remaining) != 0);
+
+		_dump_to(_get_dump_path(_get_dump_pattern(), path));
+	}
+
+	return 0;
+}
+
+// Starts the background dump thread, if the MOOCOV_DUMP_INTERVAL environment variable is set to a non-zero number of seconds.
+static void _start_background_dump() {
+	const char* intervalStr = getenv("MOOCOV_DUMP_INTERVAL");
+	if(!intervalStr) return;
+
+	unsigned long interval = strtoul(intervalStr, 0, 10);
+	if(interval == 0) return;
+
+	pthread_t thread;
+	if(pthread_create(&thread, 0, _background_dump, (void*)(uintptr_t)interval) == 0) {
+		pthread_detach(thread);
+	}
+}
+
+#endif
+
+// Prepares the data of a file for the current mode, when the file is registered. Requires the index lock.
+static void _setup_file(moocov_file_t* file) {
+	// the files defined by hand may leave the length of the ID to the runtime
+	if(!file->idLength) file->idLength = (uint32_t)strlen(file->id);
+
+	_init_active(file);
+	_map_file(file);
+	_allocate_spare(file);
+	_allocate_shadow(file);
+
+	// data gathering may be disabled already
+	_redirect_file(file);
+}
+
+// Keeps other threads from holding the locks while forking, as only the forking thread survives in the child.
+static void _prepare_fork() {
+	pthread_mutex_lock(&g_dumpLock);
+	_lock_index();
+}
+
+static void _parent_after_fork() {
+	_unlock_index();
+	pthread_mutex_unlock(&g_dumpLock);
+}
+
+// Clears the data a forked child inherited from its parent, so that it doesn't get dumped by both of them.
+static void _child_after_fork() {
+	_reset_mapping();
+	_reset_shard_registry();
+	_reset_files(1);
+	_unlock_index();
+	pthread_mutex_unlock(&g_dumpLock);
+
+#if MOOCOV_BUFFERED_COUNTERS
+	// the background dump thread of the parent doesn't survive forking
+	_start_background_dump();
+#endif
+}
+
+const char MOOCOV_RUNTIME_ANCHOR = 0;
+
+static pthread_once_t g_initOnce = PTHREAD_ONCE_INIT;
+
+// Sets up the copy of the runtime that keeps the state, when the first module registers with it.
+static void _init_runtime() {
+	pthread_atfork(_prepare_fork, _parent_after_fork, _child_after_fork);
+
+#if DUMP_SIGNAL
+	_install_signal_dump();
+#endif
+}
+
+// Takes the sections of a module, which every copy of the runtime calls from its constructor.
+// In the modes that move the data (or keep a shadow of it), the files in the sections are set up here. Other constructors may run before the module is registered, but the hits they register are kept, as the data is moved with them (even if data gathering is initially disabled).
+void MOOCOV_REGISTER_MODULE(moocov_module_t* module) {
+	pthread_once(&g_initOnce, _init_runtime);
+
+	_lock_index();
+
+	*g_modulesTail = module;
+	g_modulesTail = &module->next;
+
+#if DUMP_SIGNAL
+	_reserve_signal_dump(module->files, module->filesEnd);
+#endif
+
+#if MOOCOV_INDIRECT_DATA || INCREMENTAL_DUMPS
+	moocov_file_t* file;
+	for(file = module->files; file < module->filesEnd; ++file) {
+		_setup_file(file);
+	}
+#endif
+
+	_unlock_index();
+
+#if MOOCOV_BUFFERED_COUNTERS
+	pthread_once(&g_backgroundDumpOnce, _start_background_dump);
+#endif
+}
+
+// The sections of the executable or shared library this copy of the runtime is linked into.
+static moocov_module_t g_module;
+
+// Registers the sections when the executable or shared library is loaded.
+// The shared libraries are loaded before the program, but the program's copy of the runtime doesn't need its constructor to run to take their sections.
+// NOTE: the sections of a shared library stay registered after it's unloaded, so a library containing instrumented files must not be unloaded with dlclose().
+__attribute__((constructor)) static void _moocov_init() {
+	g_module.files = MOOCOV_SECTION_BEGIN(moocov_files);
+	g_module.filesEnd = MOOCOV_SECTION_END(moocov_files);
+	g_module.counts = MOOCOV_SECTION_BEGIN(moocov_cnts);
+	g_module.countsEnd = MOOCOV_SECTION_END(moocov_cnts);
+	g_module.flags = MOOCOV_SECTION_BEGIN(moocov_flags);
+	g_module.flagsEnd = MOOCOV_SECTION_END(moocov_flags);
+
+	MOOCOV_REGISTER_MODULE(&g_module);
+}
+
+// Adds an object to the linked list. Only needed for files that aren't in the sections.
+void _moocov_link(moocov_file_t* file) {
+	if(MOOCOV_UNLIKELY(file->linked)) return;
+
+	_lock_index();
+
+	// another thread may have linked the file in the meantime
+	if(!file->linked) {
+		_setup_file(file);
+
+#if DUMP_SIGNAL
+		_reserve_signal_dump(file, file + 1);
+#endif
+
+		g_index.tail->next = file;
+		g_index.tail = file;
+
+		file->linked = 1;
+	}
+
+	_unlock_index();
+
+#if MOOCOV_BUFFERED_COUNTERS
+	pthread_once(&g_backgroundDumpOnce, _start_background_dump);
+#endif
+}
+
+// Registers a hit on the specified signal.
+// The instrumented sources use the inline MOOCOV_SIGNAL() instead, this is only kept for code that only has a moocov_file_t pointer at hand.
+void _moocov_signal(moocov_file_t* file, moocov_data_size_t index) {
+	void* data = __atomic_load_n(&file->data, __ATOMIC_RELAXED);
+
+	if(file->kind == MOOCOV_KIND_FLAGS) {
+		MOOCOV_SET_FLAG(((moocov_flag_t*)data)[index]);
+		return;
+	}
+
+#if MOOCOV_REDIRECTED_SHARDS
+	data = __atomic_load_n(_moocov_get_shard_slot(file), __ATOMIC_RELAXED);
+#elif MOOCOV_SHARDED_COUNTERS
+	data = _moocov_get_shard(file);
+#endif
+
+#define MOOCOV_SIGNAL_CASE(KIND) \
+	case MOOCOV_##KIND##_KIND: \
+		MOOCOV_##KIND##_HIT(((MOOCOV_##KIND##_TYPE*)data)[index]); \
+		return;
+
+	switch(file->kind) {
+	MOOCOV_SIGNAL_CASE(COUNTS)
+	MOOCOV_SIGNAL_CASE(COUNTS8)
+	MOOCOV_SIGNAL_CASE(COUNTS16)
+	MOOCOV_SIGNAL_CASE(COUNTS64)
+	MOOCOV_SIGNAL_CASE(COUNTS_SAT)
+	MOOCOV_SIGNAL_CASE(COUNTS8_SAT)
+	MOOCOV_SIGNAL_CASE(COUNTS16_SAT)
+	MOOCOV_SIGNAL_CASE(COUNTS64_SAT)
+	}
+
+#undef MOOCOV_SIGNAL_CASE
 }
@@ -0,0 +1,76 @@
+// RUN: test-instrumentation %s --derive-counters --
+
+void test(int arg) {
+//% void test(int arg) {$;
+	if(arg < 3) (void)0;
+	//% if(arg < 3) {$;(void)0;}
+
+	else if(arg == 3)
+		(void)0;
+		//% {$;(void)0;}
+
+	else if(arg > 3) {}
+	//% else if(arg > 3) {$;}
+
+	else {
+		(void)0;
+	}
+
+	int abs = arg < 0 ? -arg : arg;
+	//% int abs = arg < 0 ? ($,-arg) : arg;
+
+	while(arg > 0) {
+	//% while(arg > 0) {$;
+		if(arg == 3) break;
+		//% if(arg == 3) {$;break;}
+
+		if(arg % 2 == 0) {
+		//% if(arg % 2 == 0) {$;
+			arg /= 2;
+		} else {
+			arg--;
+		}
+	}
+
+	if(arg == 0) return;
+	//% if(arg == 0) {$;return;}
+
+	if(arg < 0 || arg > 42) {}
+	//% if(arg < 0 || ($,arg > 42)) {$;}
+}
+
+void aliases(int arg) {
+//% void aliases(int arg) {$;
+	try {
+		arg++;
+	} catch(...) {
+	//% } catch(...) {$;
+		arg--;
+	}
+
+	do {
+		arg *= 2;
+	} while(0);
+}
+
+void loopConditions(int p, int a, int b) {
+//% void loopConditions(int p, int a, int b) {$;
+	while(p ? a-- : b--) {}
+	//% while(p ? ($,a--) : ($,b--)) {$;}
+
+	do {} while(p ? a-- : b--);
+	//% do {$;} while(p ? ($,a--) : ($,b--));
+}
+
+__attribute__((noreturn)) void fail();
+
+void noReturnCalls(int x, int y) {
+//% void noReturnCalls(int x, int y) {$;
+	if(x) fail();
+	//% if(x) {$;fail();}
+
+	if(y) (void)0;
+	//% if(y) {$;(void)0;}
+	else (void)1;
+	//% else {$;(void)1;}
+}
@@ -1,7 +1,7 @@
 // RUN: test-instrumentation %s
 
 void test(int x) {
-//% void test(int x) {@;$;
+//% void test(int x) {$;
 
 	int abs = x < 0 ? -x : x;
 	//% int abs = x < 0 ? ($,-x) : ($,x);
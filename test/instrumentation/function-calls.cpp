@@ -6,7 +6,7 @@
 void external();
 
 void test() {
-//% void test() {@;$;
+//% void test() {$;
 	external();
 	//% external();$;
 }
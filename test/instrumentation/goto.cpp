@@ -2,7 +2,7 @@
 void external_foo();
 
 void stuff(bool x) {
-//% void stuff(bool x) {@;$;
+//% void stuff(bool x) {$;
 start:
 	external_foo();
 	//% $;external_foo();
@@ -0,0 +1,16 @@
+// RUN: test-instrumentation %s --granularity=block --
+
+int test(int x) {
+//% int test(int x) {$;
+	int abs = x < 0 ? -x : x;
+
+	if(x == 0 || x > 42) return 0;
+	//% if(x == 0 || x > 42) {$;return 0;}$;
+
+	while(x > 0 && abs != 0) {
+	//% while(x > 0 && abs != 0) {$;
+		abs -= x--;
+	}
+
+	return abs;
+}
@@ -0,0 +1,23 @@
+// RUN: test-instrumentation %s --granularity=function --
+
+int test(int x) {
+//% int test(int x) {$;
+	int abs = x < 0 ? -x : x;
+
+	if(x == 0 || x > 42) return 0;
+	else abs++;
+
+	for(int i = 0; i < x; ++i) {
+		if(i == 10) break;
+		abs += i;
+	}
+
+	switch(x) {
+	case 1:
+		return 1;
+	default:
+		break;
+	}
+
+	return abs;
+}
@@ -1,7 +1,7 @@
 // RUN: test-instrumentation %s
 
 void test(int arg) {
-//% void test(int arg) {@;$;
+//% void test(int arg) {$;
 	if(arg < 3) (void)0;
 	//% if(arg < 3) {$;(void)0;}
 
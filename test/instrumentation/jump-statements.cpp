@@ -1,7 +1,7 @@
 // RUN: test-instrumentation %s
 
 void test(int x) {
-//% void test(int x) {@;$;
+//% void test(int x) {$;
 	if(x < 0) return;
 	//% if(x < 0) {$;return;}$;
 
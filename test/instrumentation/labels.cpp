@@ -2,7 +2,7 @@
 // XFAIL: *
 
 void goto_test(bool x) {
-//% void goto_test(bool x) {@;$;
+//% void goto_test(bool x) {$;
 start:
 	int y;
 	//% $;int y;
@@ -12,7 +12,7 @@ start:
 }
 
 void switch_test(int x) {
-//% void switch_test(int x) {@;$;
+//% void switch_test(int x) {$;
 	switch(x) {
 	//% switch(x) {$;
 
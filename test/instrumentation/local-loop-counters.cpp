@@ -0,0 +1,56 @@
+// RUN: test-instrumentation %s --local-loop-counters --
+
+void test(const int* values, int n, int* result) {
+//% void test(const int* values, int n, int* result) {$;
+	int sum = 0;
+	for(int i = 0; i < n; ++i) {
+	//% {moocov_data_size_t _moocov_iterations1 = 0;for(int i = 0; i < n; ++i) {++_moocov_iterations1;
+		if(values[i] < 0) continue;
+		//% if(values[i] < 0) {$;continue;}$;
+		sum += values[i];
+	}
+	//% }$;}
+
+	while(sum > 100)
+	//% {moocov_data_size_t _moocov_iterations4 = 0;while(sum > 100)
+		sum /= 2;
+		//% {++_moocov_iterations4;sum /= 2;}$;}
+
+	while(n > 0) {
+	//% while(n > 0) {$;
+		if(n == 42) return;
+		//% if(n == 42) {$;return;}$;
+		n--;
+	}
+
+	*result = sum;
+}
+
+void placement(int x, int y) {
+//% void placement(int x, int y) {$;
+	do {
+	//% {moocov_data_size_t _moocov_iterations9 = 0;do {++_moocov_iterations9;
+		x--;
+	} while(x > 0);
+	//% } while(x > 0);$;}
+
+	do x--; while(x > 0);
+	//% {moocov_data_size_t _moocov_iterations10 = 0;do {++_moocov_iterations10;x--;} while(x > 0);$;}
+
+	if(x)
+		while(y) y--;
+		//% {$;{moocov_data_size_t _moocov_iterations12 = 0;while(y) {++_moocov_iterations12;y--;}$;}}
+	else
+		while(y < 3) y++;
+		//% {$;{moocov_data_size_t _moocov_iterations14 = 0;while(y < 3) {++_moocov_iterations14;y++;}$;}}
+
+	// the flush has to come after the end of the then branch in the body
+	while(y > 0)
+	//% {moocov_data_size_t _moocov_iterations15 = 0;while(y > 0)
+		if(y-- == 2) x++;
+		//% {++_moocov_iterations15;if(y-- == 2) {$;x++;}}$;}
+
+label:
+	while(x < 5) x++;
+	//% $;{moocov_data_size_t _moocov_iterations18 = 0;while(x < 5) {++_moocov_iterations18;x++;}$;}
+}
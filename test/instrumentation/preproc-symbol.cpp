@@ -5,9 +5,9 @@
 #ifdef MOOCOV_INSTRUMENT
 
 void moocov_guarded() {}
-//% void moocov_guarded() {@;$;}
+//% void moocov_guarded() {$;}
 
 #endif // MOOCOV_INSTRUMENT
 
 void unguarded() {}
-//% void unguarded() {@;$;}
+//% void unguarded() {$;}
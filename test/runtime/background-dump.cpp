@@ -0,0 +1,25 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --counters=buffered -- -std=c++11
+// RUN: build-runtime -DMOOCOV_ATOMIC_COUNTERS=1 -DMOOCOV_BUFFERED_COUNTERS=1 -o %t.runtime.o
+// RUN: %cxx -w -std=c++11 -pthread %t.d/background-dump.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- env MOOCOV_DUMP_INTERVAL=1 %t.exe
+
+#include <thread>
+#include <unistd.h>
+
+// runs for about 2 seconds, so the data gets dumped in the background while the threads are hitting the signals
+void work() {
+	for(int r = 0; r < 200; ++r) {
+		for(int i = 0; i < 10000; ++i) {} // TAKEN: 8000000
+		usleep(10000);
+	}
+}
+
+int main(int argc, const char** argv) {
+	std::thread threads[4];
+	for(std::thread& t : threads) t = std::thread{work};
+	for(std::thread& t : threads) t.join();
+
+	// the rest of the data is dumped at exit
+	return 0;
+}
@@ -0,0 +1,41 @@
+// RUN: rm -rf %t.d %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --
+// RUN: %cxx -w %t.d/contexts.cpp %runtime_lib -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+#include <stdlib.h>
+
+static void runTest(int count) {
+	for(int i = 0; i < count; ++i) {} // TAKEN: 5
+}
+
+int main(int argc, const char** argv) {
+	// each context switch dumps the hits so far, but the data file still adds up to all of them
+#ifdef MOOCOV
+	moocov_set_context("first test");
+#endif
+
+	runTest(argc);
+
+#ifdef MOOCOV
+	moocov_set_context("second test");
+#endif
+
+	runTest(2);
+
+	if(argc > 5) {} // TAKEN: 0
+
+#ifdef MOOCOV
+	// if the hits so far can't be dumped, they stay with the active context
+	setenv("MOOCOV_DUMP_FILE", "/nonexistent/coverage.mocd", 1);
+	if(moocov_set_context("lost test")) return 1;
+	unsetenv("MOOCOV_DUMP_FILE");
+#endif
+
+#ifdef MOOCOV
+	moocov_set_context(0);
+	moocov_dump();
+#endif
+
+	return 0;
+}
@@ -1,5 +1,5 @@
 // RUN: rm -rf %t.d %t.runtime.o %t.exe
-// RUN: moocov-instrument %s -o %t.d -m %t.d --
+// RUN: moocov-instrument %s -o %t.d -m %t.d --allow-disable --
 // RUN: build-runtime -DALLOW_DISABLE=1 -DINITIAL_ENABLED=0 -o %t.runtime.o
 // RUN: %cxx -w %t.d/controls.cpp %t.runtime.o -I%runtime_incl -o %t.exe
 // RUN: test-coverage %s %t.d -- %t.exe x y
@@ -0,0 +1,15 @@
+// RUN: rm -rf %t.d %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --counter-width=8 --saturating --
+// RUN: %cxx -w %t.d/counter-width.cpp %runtime_lib -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe
+
+int main(int argc, const char** argv) {
+	// the 8-bit counter stops at 255 instead of wrapping around
+	for(int i = 0; i < 1000; ++i) {} // TAKEN: 255
+
+	for(int i = 0; i < 200; ++i) {} // TAKEN: 200
+
+	if(argc > 5) {} // TAKEN: 0
+
+	return 0;
+}
@@ -0,0 +1,62 @@
+// RUN: rm -rf %t.d %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --derive-counters --
+// RUN: %cxx -w %t.d/derived-counters.cpp %runtime_lib -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe
+
+// the else branches and the code after the jumps get no counters, but their hit counts are computed from the others
+static int classify(int x) {
+	int result = 0;
+
+	if(x < 0)
+	{ // TAKEN: 3
+		return -1;
+	}
+	else
+	{ // TAKEN: 10
+		result = 1;
+	}
+
+	for(int i = 0; i < x; ++i)
+	{ // TAKEN: 35
+		if(i == 4) break; // TAKEN: 30
+		result += i % 2 == 0
+			? 2 // TAKEN: 16
+			: 1; // TAKEN: 14
+	}
+
+	// try blocks are entered as many times as the code around them runs, so they share its count
+	try
+	{ // TAKEN: 10
+		result *= 2;
+	}
+	catch(...)
+	{ // TAKEN: 0
+		result = 0;
+	}
+
+	return result;
+}
+
+int main(int argc, const char** argv) {
+	int sum = 0;
+	for(int x = -3; x < 10; ++x) {
+		sum += classify(x);
+	}
+
+	// loop conditions run once per iteration, not once per entry to the loop, so their alternatives keep their counters
+	int n = 3, m = 2;
+	while(n > 0
+		? n-- // TAKEN: 3
+		: m--) // TAKEN: 3
+	{
+	}
+
+	do {} while(n < 2
+		? ++n // TAKEN: 2
+		: 0); // TAKEN: 1
+
+#ifdef MOOCOV
+	moocov_dump();
+#endif
+	return sum == 0;
+}
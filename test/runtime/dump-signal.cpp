@@ -0,0 +1,20 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --
+// RUN: build-runtime -DDUMP_SIGNAL=SIGUSR1 -o %t.runtime.o
+// RUN: %cxx -w %t.d/dump-signal.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+#include <signal.h>
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	// the handler dumps the hits so far in the text format, the rest is dumped in the binary format at exit
+	raise(SIGUSR1);
+
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	if(argc > 5) {} // TAKEN: 0
+
+	return 0;
+}
@@ -0,0 +1,19 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --
+// RUN: build-runtime -DCOMPACT_DUMPFILE=0 -o %t.runtime.o
+// RUN: %cxx -w %t.d/fixed-width-dumpfile.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	for(int i = 0; i < 1000; ++i) {} // TAKEN: 1000
+
+	if(argc > 5) {} // TAKEN: 0
+
+#ifdef MOOCOV
+	moocov_dump();
+#endif
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --
+// RUN: build-runtime -o %t.runtime.o
+// RUN: %cxx -w %t.d/fork.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- env MOOCOV_DUMP_FILE=coverage.%%p.mocd %t.exe a b
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	// the child starts with no data of its own, so the hits above aren't dumped twice
+	pid_t pid = fork();
+	if(pid == 0) {
+		for(int i = 0; i < 2; ++i) {} // TAKEN: 2
+		return 0;
+	}
+
+	waitpid(pid, 0, 0);
+
+	if(argc > 5) {} // TAKEN: 0
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+// RUN: rm -rf %t.d %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --hit-only --
+// RUN: %cxx -w %t.d/hit-only.cpp %runtime_lib -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < 1000; ++i) {} // TAKEN: 1
+
+	if(argc > 5) {} // TAKEN: 0
+
+#ifdef MOOCOV
+	moocov_dump();
+#endif
+
+	return 0;
+}
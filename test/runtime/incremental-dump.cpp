@@ -0,0 +1,25 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --
+// RUN: build-runtime -DINCREMENTAL_DUMPS=1 -o %t.runtime.o
+// RUN: %cxx -w %t.d/incremental-dump.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+#ifdef MOOCOV
+	// the counters are kept, so each dump only writes what was hit since the previous one
+	moocov_dump();
+#endif
+
+	if(argc > 1) {} // TAKEN: 1
+
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+#ifdef MOOCOV
+	moocov_dump();
+	moocov_dump();
+#endif
+
+	if(argc > 5) {} // TAKEN: 0
+}
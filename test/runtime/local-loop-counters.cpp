@@ -0,0 +1,38 @@
+// RUN: rm -rf %t.d %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --local-loop-counters --
+// RUN: %cxx -w %t.d/local-loop-counters.cpp %runtime_lib -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe
+
+// a loop that can return keeps its counter
+static int countdown(int n) {
+	while(n > 0) { // TAKEN: 7
+		if(n == 3) return n;
+		n--;
+	}
+
+	return 0;
+}
+
+int main(int argc, const char** argv) {
+	// the iterations of these are counted in local variables, and added to the counters once the loops are done
+	int sum = 0;
+	for(int i = 0; i < 10; ++i) { // TAKEN: 10
+		for(int j = 0; j < i; ++j) { // TAKEN: 39
+			if(j == 5) break;
+			sum += j;
+		}
+	}
+
+	int n = 0;
+	do { // TAKEN: 20
+		if(++n % 2) continue;
+		sum += n;
+	} while(n < 20);
+
+	sum += countdown(9);
+
+#ifdef MOOCOV
+	moocov_dump();
+#endif
+	return sum == 0;
+}
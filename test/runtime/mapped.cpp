@@ -0,0 +1,16 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --mapped-counters --
+// RUN: build-runtime -DMOOCOV_MAPPED_COUNTERS=1 -o %t.runtime.o
+// RUN: %cxx -w %t.d/mapped.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+#include <unistd.h>
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	if(argc > 5) {} // TAKEN: 0
+
+	// exit without moocov_dump(), as if the program crashed
+	_exit(0);
+}
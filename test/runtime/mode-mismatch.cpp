@@ -0,0 +1,12 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --allow-disable --
+// RUN: build-runtime -o %t.runtime.o
+// RUN: not %cxx -w %t.d/mode-mismatch.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+
+// The files instrumented with --allow-disable have a larger moocov_file_t than a runtime built without ALLOW_DISABLE expects, so linking them has to fail.
+
+int main(int argc, const char** argv) {
+	if(argc > 1) {}
+
+	return 0;
+}
@@ -0,0 +1,30 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.runtime-pic.o %t.lib.so %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d -- -DBUILD_LIBRARY -DBUILD_PROGRAM
+// RUN: build-runtime -fPIC -o %t.runtime-pic.o
+// RUN: %cxx -w -shared -fPIC -DBUILD_LIBRARY %t.d/shared-library.cpp %t.runtime-pic.o -I%runtime_incl -o %t.lib.so
+// RUN: build-runtime -o %t.runtime.o
+// RUN: %cxx -w -DBUILD_PROGRAM %t.d/shared-library.cpp %t.runtime.o %t.lib.so -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+// The library and the program are built from the same instrumented file, and both link their own copy of the runtime.
+// The library's copy registers its files with the program's, which dumps them with its own at exit.
+
+#ifdef BUILD_LIBRARY
+void work(int count) {
+	for(int i = 0; i < count; ++i) {} // TAKEN: 5
+}
+#endif
+
+#ifdef BUILD_PROGRAM
+void work(int count);
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	work(5);
+
+	if(argc > 5) {} // TAKEN: 0
+
+	return 0;
+}
+#endif
@@ -0,0 +1,39 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --mapped-counters --
+// RUN: build-runtime -DMOOCOV_MAPPED_COUNTERS=1 -DMAPFILE_SHARED_MEMORY=1 -o %t.runtime.o
+// RUN: %cxx -w %t.d/shared-memory.cpp %t.runtime.o -I%runtime_incl -lrt -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Copies the counter file of the process out of shared memory, like moocov-top would read it, so that test-coverage finds it.
+static void copyCounters() {
+	char name[64];
+	snprintf(name, sizeof(name), "/moocov.%d", (int)getpid());
+
+	int in = shm_open(name, O_RDONLY, 0);
+	int out = open("coverage.shm.mocd", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	char buffer[4096];
+	ssize_t size;
+	while((size = read(in, buffer, sizeof(buffer))) > 0) {
+		write(out, buffer, size);
+	}
+
+	close(out);
+	close(in);
+	shm_unlink(name);
+}
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	if(argc > 5) {} // TAKEN: 0
+
+	// exit without moocov_dump(): the counters are only in shared memory
+	copyCounters();
+	_exit(0);
+}
@@ -0,0 +1,18 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.libmoocovrt.a %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --mapped-counters --auto-dump=false --
+// RUN: build-runtime -DMOOCOV_MAPPED_COUNTERS=1 -o %t.runtime.o
+// RUN: ar rcs %t.libmoocovrt.a %t.runtime.o
+// RUN: %cxx -w %t.d/static-library.cpp %t.libmoocovrt.a -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+// The instrumented code doesn't call the runtime, which still has to be linked from the archive, as its constructor sets up the counter file.
+
+#include <unistd.h>
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	if(argc > 5) {} // TAKEN: 0
+
+	_exit(0);
+}
@@ -0,0 +1,17 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --
+// RUN: build-runtime -DTEXT_DUMPFILE=1 -o %t.runtime.o
+// RUN: %cxx -w %t.d/text-dumpfile.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+int main(int argc, const char** argv) {
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	if(argc > 5) {} // TAKEN: 0
+
+#ifdef MOOCOV
+	moocov_dump();
+#endif
+
+	return 0;
+}
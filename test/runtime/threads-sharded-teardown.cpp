@@ -0,0 +1,39 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --counters=sharded --
+// RUN: build-runtime -DMOOCOV_SHARDED_COUNTERS=1 -o %t.runtime.o
+// RUN: %cxx -w -pthread %t.d/threads-sharded-teardown.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe a b
+
+#include <pthread.h>
+
+static pthread_key_t g_key;
+
+// Runs after the runtime has released the shards of the exiting thread, as the runtime's key was created first.
+// The hits still go to the shard the thread cached.
+static void teardown(void*) {
+	for(int i = 0; i < 3; ++i) {} // TAKEN: 12
+}
+
+static void* work(void*) {
+	for(int i = 0; i < 2; ++i) {} // TAKEN: 8
+
+	pthread_setspecific(g_key, &g_key);
+	return 0;
+}
+
+int main(int argc, const char** argv) {
+	// allocates the first shard, which creates the runtime's key
+	for(int i = 0; i < argc; ++i) {} // TAKEN: 3
+
+	pthread_key_create(&g_key, teardown);
+
+	pthread_t threads[4];
+	for(int i = 0; i < 4; ++i) pthread_create(&threads[i], 0, work, 0);
+	for(int i = 0; i < 4; ++i) pthread_join(threads[i], 0);
+
+#ifdef MOOCOV
+	moocov_dump();
+#endif
+
+	return 0;
+}
@@ -0,0 +1,23 @@
+// RUN: rm -rf %t.d %t.runtime.o %t.exe
+// RUN: moocov-instrument %s -o %t.d -m %t.d --counters=sharded -- -std=c++11
+// RUN: build-runtime -DMOOCOV_SHARDED_COUNTERS=1 -o %t.runtime.o
+// RUN: %cxx -w -std=c++11 -pthread %t.d/threads-sharded.cpp %t.runtime.o -I%runtime_incl -o %t.exe
+// RUN: test-coverage %s %t.d -- %t.exe
+
+#include <thread>
+
+void work() {
+	for(int i = 0; i < 100000; ++i) {} // TAKEN: 800000
+}
+
+int main(int argc, const char** argv) {
+	std::thread threads[8];
+	for(std::thread& t : threads) t = std::thread{work};
+	for(std::thread& t : threads) t.join();
+
+#ifdef MOOCOV
+	moocov_dump();
+#endif
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 #define MOO2GCOV_CONVERTEROPTIONS_H
 
 #include <string>
+#include <cstddef>
 
 namespace moo2gcov {
 
@@ -11,6 +12,13 @@ public:
 	bool omitUnexecutedFiles;
 	bool emitSimpleHitCount;
 
+	/// \brief The number of dumps to read from each data file (see libmoocov::CoverageData::read()).
+	std::size_t numDumps;
+
+	/// \brief Whether to only use the hits made while a given context was active (see moocov_set_context()).
+	bool filterContext;
+	std::string context;
+
 	bool outputToStdout() const {
 		return outputDirectory == "-";
 	}
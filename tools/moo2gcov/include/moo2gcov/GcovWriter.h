@@ -30,6 +30,9 @@ private:
 	void _emitPreamble(std::ostream& os);
 
 	bool _nextLine(std::string& sourceLine);
+
+	/// \brief Whether the hits of the given signal covering the current line are the hit count of the line.
+	bool _isCountedOnLine(const libmoocov::SignalMapping& signal, const std::string& sourceLine) const;
 	void _emitCode(std::ostream& os);
 
 	const libmoocov::SourceFileMap& m_sourceFileMap;
@@ -70,17 +70,30 @@ static bool isEmptyLine(const std::string& line) {
 	return true;
 }
 
+bool GcovWriter::_isCountedOnLine(const libmoocov::SignalMapping& signal, const std::string& sourceLine) const {
+	// the signals of function-level maps only count the calls of the functions, not how many times their lines ran, so they're only shown on the line the function body starts on
+	if(m_sourceFileMap.getGranularity(signal.fileID) == libmoocov::Granularity::Function) {
+		return signal.sourceRange.begin.line == m_lineCoverage.getCurrentLine();
+	}
+
+	return !isEmptyLine(sourceLine);
+}
+
 void GcovWriter::_emitCode(std::ostream& os) {
 	std::string sourceLine;
 	while(_nextLine(sourceLine)) {
-		if(!m_lineCoverage.isLineCovered() || isEmptyLine(sourceLine)) {
+		bool isExecutable = false;
+		std::size_t hitCount = 0;
+		for(const libmoocov::SignalMapping& coveringSignal : m_lineCoverage.getMostSpecificSignals()) {
+			if(!_isCountedOnLine(coveringSignal, sourceLine)) continue;
+
+			isExecutable = true;
+			hitCount = std::max(hitCount, m_coverageData.getHitCount(coveringSignal.fileID, coveringSignal.id));
+		}
+
+		if(!isExecutable) {
 			os << std::setw(fieldWidth) << std::right << "-";
 		} else {
-			std::size_t hitCount = 0;
-			for(const libmoocov::SignalMapping& coveringSignal : m_lineCoverage.getMostSpecificSignals()) {
-				hitCount = std::max(hitCount, m_coverageData.getHitCount(coveringSignal.fileID, coveringSignal.id));
-			}
-
 			if(hitCount == 0 && !m_opts.emitSimpleHitCount) {
 				// NOTE: in the gcov format, we should use '=' instead of '#' if the line is only reachable in an exceptional branch (i.e. in the C++ catch block), but we don't store that information
 				os << std::string(fieldWidth, '#');
@@ -1,6 +1,9 @@
+#include <map>
 #include <string>
 #include <system_error>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "llvm/ADT/StringMap.h"
 
@@ -40,10 +43,29 @@ static cl::opt<bool> g_emitSimpleHitCount{"simple-hitcount",
 	cl::init(false)
 };
 
+static cl::opt<unsigned> g_numDumps{"dumps",
+	cl::desc("Only use the first n dumps of each data file, to get the coverage as it was when the n-th dump was made (0: use all of them)"),
+	cl::value_desc("n"),
+	cl::init(0)
+};
+
+static cl::opt<std::string> g_context{"context",
+	cl::desc("Only use the hits made while the given context was active in the instrumented program (see moocov_set_context()), e.g. by a single test case"),
+	cl::value_desc("name")
+};
+
 static bool populateOptions(ConverterOptions& opts) {
 	opts.outputDirectory = g_outputPath;
 	opts.omitUnexecutedFiles = g_omitUnexecutedFiles;
 	opts.emitSimpleHitCount = g_emitSimpleHitCount;
+	opts.numDumps = g_numDumps == 0 ? libmoocov::CoverageData::allDumps : g_numDumps;
+	opts.filterContext = g_context.getNumOccurrences() > 0;
+	opts.context = g_context;
+
+	if(opts.filterContext && g_numDumps != 0) {
+		llvm::errs() << "-context and -dumps can't be used together!\n";
+		return false;
+	}
 
 	if(!opts.outputToStdout()) {
 		if(llvm::sys::fs::exists(opts.outputDirectory)) {
@@ -73,6 +95,18 @@ static bool isMapFile(llvm::StringRef fileName) {
 	return fileName.endswith(".mocm");
 }
 
+static bool readDataFile(const std::string& path, const ConverterOptions& opts, libmoocov::CoverageData& coverageData) {
+	if(!opts.filterContext) return coverageData.read(path, opts.numDumps);
+
+	std::map<std::string, libmoocov::CoverageData> contexts;
+	if(!libmoocov::CoverageData::readContexts(path, contexts)) return false;
+
+	auto it = contexts.find(opts.context);
+	if(it != contexts.end()) coverageData.update(it->second);
+
+	return true;
+}
+
 int main(int argc, const char** argv) {
 	cl::ParseCommandLineOptions(argc, argv);
 
@@ -85,10 +119,13 @@ int main(int argc, const char** argv) {
 	llvm::StringMap<libmoocov::SourceFileMap> sourceMaps;
 	libmoocov::CoverageData coverageData;
 
+	// the maps with signals whose hit counts have to be computed once all data is read
+	std::vector<libmoocov::SignalMap> derivedMaps;
+
 	// process the input files
 	for(const std::string& inputFilePath : g_inputFiles) {
 		if(isDataFile(inputFilePath)) {
-			if(!coverageData.read(inputFilePath)) {
+			if(!readDataFile(inputFilePath, opts, coverageData)) {
 				llvm::errs() << "Warning: failed to read data file '" << inputFilePath << "', skipping.\n";
 			}
 		} else if(isMapFile(inputFilePath)) {
@@ -105,11 +142,17 @@ int main(int argc, const char** argv) {
 			}
 
 			it->second.addSignalMap(signalMap);
+
+			if(!signalMap.derivedSignals.empty()) derivedMaps.push_back(std::move(signalMap));
 		} else {
 			llvm::errs() << "Warning: unrecognized file extension for input file '" << inputFilePath << "' - file ignored.\n";
 		}
 	}
 
+	for(const libmoocov::SignalMap& signalMap : derivedMaps) {
+		coverageData.addDerivedHitCounts(signalMap);
+	}
+
 	// run GcovWriter for each SourceFileMap
 	for(const auto& sourceMapEntry : sourceMaps) {
 		GcovWriter writer{sourceMapEntry.second, coverageData, opts};
@@ -0,0 +1,39 @@
+#ifndef MOOCOVTOP_LIVECOUNTERS_H
+#define MOOCOVTOP_LIVECOUNTERS_H
+
+#include <string>
+#include <cstddef>
+
+#include "libmoocov/CoverageData.h"
+
+namespace moocovtop {
+
+/// \brief A read-only view of the counter file of a running program, built with MOOCOV_MAPPED_COUNTERS (and possibly MAPFILE_SHARED_MEMORY).
+/// The counters are read straight from the memory of the program, so watching them doesn't cost the program anything.
+class LiveCounters {
+public:
+	/*implicit*/ LiveCounters() = default;
+	~LiveCounters() { close(); }
+
+	LiveCounters(const LiveCounters&) = delete;
+	LiveCounters& operator=(const LiveCounters&) = delete;
+
+	/// \brief Opens a counter file: a shared memory object if the name starts with a slash and has no other slashes in it, a regular file otherwise.
+	bool open(const std::string& name);
+	void close();
+
+	/// \brief Reads the current values of the counters.
+	/// If the program has grown the counter file since the last call, it's mapped again.
+	bool read(libmoocov::CoverageData& coverage);
+
+private:
+	bool _map();
+
+	int m_fd = -1;
+	const char* m_data = nullptr;
+	std::size_t m_size = 0;
+};
+
+} // end namespace moocovtop
+
+#endif // MOOCOVTOP_LIVECOUNTERS_H
@@ -0,0 +1,25 @@
+#ifndef MOOCOVTOP_VIEWEROPTIONS_H
+#define MOOCOVTOP_VIEWEROPTIONS_H
+
+#include <string>
+
+namespace moocovtop {
+
+class ViewerOptions {
+public:
+	/// \brief The counter file to watch: a shared memory object or a regular file (see LiveCounters::open()).
+	std::string counterFile;
+
+	/// \brief The time between two refreshes, in milliseconds.
+	unsigned interval;
+
+	/// \brief The number of refreshes to show before exiting, or 0 to keep watching until interrupted.
+	unsigned iterations;
+
+	/// \brief Whether to redraw the screen on each refresh, instead of just printing the refreshes one after the other.
+	bool redraw;
+};
+
+} // end namespace moocovtop
+
+#endif // MOOCOVTOP_VIEWEROPTIONS_H
@@ -0,0 +1,63 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "moocovtop/LiveCounters.h"
+
+namespace moocovtop {
+
+static bool isSharedMemoryName(const std::string& name) {
+	return name.size() > 1 && name[0] == '/' && name.find('/', 1) == std::string::npos;
+}
+
+bool LiveCounters::open(const std::string& name) {
+	close();
+
+	m_fd = isSharedMemoryName(name)
+		? shm_open(name.c_str(), O_RDONLY, 0)
+		: ::open(name.c_str(), O_RDONLY);
+
+	return m_fd >= 0;
+}
+
+void LiveCounters::close() {
+	if(m_data) munmap(const_cast<char*>(m_data), m_size);
+	if(m_fd >= 0) ::close(m_fd);
+
+	m_fd = -1;
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool LiveCounters::_map() {
+	struct stat info;
+	if(fstat(m_fd, &info) != 0) return false;
+
+	std::size_t size = static_cast<std::size_t>(info.st_size);
+	if(m_data && size == m_size) return true;
+
+	// the counter file only ever grows, with new chunks at its end
+	if(m_data) munmap(const_cast<char*>(m_data), m_size);
+	m_data = nullptr;
+	m_size = 0;
+
+	// the program may not have created the first chunk yet
+	if(size == 0) return true;
+
+	void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+	if(data == MAP_FAILED) return false;
+
+	m_data = static_cast<const char*>(data);
+	m_size = size;
+	return true;
+}
+
+bool LiveCounters::read(libmoocov::CoverageData& coverage) {
+	if(m_fd < 0 || !_map()) return false;
+	if(!m_data) return true;
+
+	return coverage.readBuffer(llvm::StringRef{m_data, m_size});
+}
+
+} // end namespace moocovtop
@@ -0,0 +1,186 @@
+#include <string>
+#include <chrono>
+#include <thread>
+
+#include "llvm/ADT/DenseMap.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+
+#include "libmoocov/CoverageMap.h"
+#include "libmoocov/CoverageData.h"
+
+#include "moocovtop/ViewerOptions.h"
+#include "moocovtop/LiveCounters.h"
+
+using namespace llvm;
+using namespace moocovtop;
+
+static cl::opt<std::string> g_counterFile{
+	cl::Positional,
+	cl::desc("<process ID or counter file>"),
+	cl::Required
+};
+
+static cl::list<std::string> g_mapFiles{
+	cl::Positional,
+	cl::desc("<map files>"),
+	cl::ZeroOrMore
+};
+
+static cl::opt<unsigned> g_interval{"interval",
+	cl::desc("Time between refreshes, in milliseconds"),
+	cl::value_desc("ms"),
+	cl::init(1000)
+};
+
+static cl::opt<unsigned> g_iterations{"n",
+	cl::desc("Number of refreshes to show before exiting (0: keep watching until interrupted)"),
+	cl::value_desc("count"),
+	cl::init(0)
+};
+
+static bool isProcessID(llvm::StringRef str) {
+	return !str.empty() && str.find_first_not_of("0123456789") == llvm::StringRef::npos;
+}
+
+static void populateOptions(ViewerOptions& opts) {
+	// a process ID refers to the shared memory object named by the default MAPFILE_NAME_FORMAT of the runtime
+	opts.counterFile = isProcessID(g_counterFile) ? "/moocov." + g_counterFile : g_counterFile;
+	opts.interval = g_interval;
+	opts.iterations = g_iterations;
+	opts.redraw = llvm::sys::Process::StandardOutIsDisplayed();
+}
+
+// The totals of a file, or of all the files.
+struct Summary {
+	std::size_t covered = 0;
+	std::size_t newlyCovered = 0;
+	std::size_t hits = 0;
+};
+
+using SignalMaps = llvm::DenseMap<libmoocov::FileID, libmoocov::SignalMap>;
+
+static void printFileName(llvm::raw_ostream& os, libmoocov::FileID fileID, const SignalMaps& maps) {
+	auto it = maps.find(fileID);
+	if(it != maps.end()) os << it->second.sourceFilePath << " (" << fileID << ")";
+	else os << fileID;
+}
+
+static void printSignal(llvm::raw_ostream& os, libmoocov::FileID fileID, libmoocov::signalid_t signalID, const SignalMaps& maps) {
+	auto it = maps.find(fileID);
+	if(it != maps.end()) {
+		auto signal = it->second.signals.find(signalID);
+		if(signal != it->second.signals.end()) {
+			const libmoocov::SourceLocation& begin = signal->second.sourceRange.begin;
+			os << it->second.sourceFilePath << ":" << begin.line << ":" << begin.column;
+			return;
+		}
+	}
+
+	os << fileID << " #" << signalID;
+}
+
+// Prints the hits of every file, and the signals that weren't covered at the previous refresh.
+static void printRefresh(llvm::raw_ostream& os, const ViewerOptions& opts, const libmoocov::CoverageData& current, const libmoocov::CoverageData& previous, const SignalMaps& maps) {
+	llvm::DenseMap<libmoocov::FileID, Summary> summaries;
+	Summary total;
+
+	for(libmoocov::FileID fileID : current.getFiles()) {
+		Summary& summary = summaries[fileID];
+
+		for(const auto& pair : current.getFileCoverage(fileID)->getHitCounts()) {
+			if(pair.second == 0) continue;
+
+			++summary.covered;
+			summary.hits += pair.second;
+			if(previous.getHitCount(fileID, pair.first) == 0) ++summary.newlyCovered;
+		}
+
+		total.covered += summary.covered;
+		total.newlyCovered += summary.newlyCovered;
+		total.hits += summary.hits;
+	}
+
+	if(opts.redraw) os << "\033[H\033[2J";
+
+	os << opts.counterFile << ": " << current.getFiles().size() << " files, "
+		<< total.covered << " signals covered (+" << total.newlyCovered << "), " << total.hits << " hits\n\n";
+
+	os << "   covered        new              hits  file\n";
+	for(libmoocov::FileID fileID : current.getFiles()) {
+		const Summary& summary = summaries[fileID];
+		os << llvm::format("%10zu %10s %17zu  ", summary.covered, ("+" + std::to_string(summary.newlyCovered)).c_str(), summary.hits);
+		printFileName(os, fileID, maps);
+		os << "\n";
+	}
+
+	if(total.newlyCovered == 0) {
+		os << "\n";
+		os.flush();
+		return;
+	}
+
+	os << "\nnewly covered:\n";
+	for(libmoocov::FileID fileID : current.getFiles()) {
+		if(summaries[fileID].newlyCovered == 0) continue;
+
+		for(const auto& pair : current.getFileCoverage(fileID)->getHitCounts()) {
+			if(pair.second == 0 || previous.getHitCount(fileID, pair.first) != 0) continue;
+
+			os << "  ";
+			printSignal(os, fileID, pair.first, maps);
+			os << "\n";
+		}
+	}
+
+	os << "\n";
+	os.flush();
+}
+
+int main(int argc, const char** argv) {
+	cl::ParseCommandLineOptions(argc, argv, "Shows the coverage of a running program built with MOOCOV_MAPPED_COUNTERS\n");
+
+	ViewerOptions opts;
+	populateOptions(opts);
+
+	// the map files are used for showing source locations instead of signal IDs, and for the hits of the signals without counters
+	SignalMaps maps;
+	for(const std::string& mapFilePath : g_mapFiles) {
+		libmoocov::SignalMap signalMap;
+		if(!signalMap.read(mapFilePath)) {
+			llvm::errs() << "Error: failed to read map file '" << mapFilePath << "'!\n";
+			return 2;
+		}
+
+		maps[signalMap.fileID] = signalMap;
+	}
+
+	LiveCounters counters;
+	if(!counters.open(opts.counterFile)) {
+		llvm::errs() << "Error: failed to open counter file '" << opts.counterFile << "'!\n";
+		return 1;
+	}
+
+	libmoocov::CoverageData previous;
+	for(unsigned i = 0; opts.iterations == 0 || i < opts.iterations; ++i) {
+		if(i != 0) std::this_thread::sleep_for(std::chrono::milliseconds(opts.interval));
+
+		libmoocov::CoverageData current;
+		if(!counters.read(current)) {
+			llvm::errs() << "Error: failed to read counter file '" << opts.counterFile << "'!\n";
+			return 2;
+		}
+
+		for(const auto& pair : maps) {
+			current.addDerivedHitCounts(pair.second);
+		}
+
+		printRefresh(llvm::outs(), opts, current, previous, maps);
+		previous = std::move(current);
+	}
+
+	return 0;
+}